@@ -23,6 +23,7 @@
  */
 #pragma once
 #include "ObxdVoice.h"
+#include "SimdFloat.h"
 class AdsrEnvelope
 {
 private:
@@ -33,7 +34,42 @@ private:
         int state;//1 - attack 2- decay 3 - sustain 4 - release 5-silence
 		float SampleRate;
 		float uf;
+		//per parameter coefficients, kept current by the setters so triggers and
+		//the attack to decay step do not call log
+		float attackCoef,decayCoef;
+		double logSustain;
+		void updateCoefs()
+		{
+			logSustain = log(jmin(sustain + 0.0001,0.99));
+			attackCoef = (float)((log(0.001) - log(1.3)) / (SampleRate * (attack)/1000 ));
+			decayCoef = (float)((logSustain - log(1.0)) / (SampleRate * (decay) / 1000));
+		}
+		//attack runs on the distance to 1, decay and release on the value itself,
+		//both shrink by g = 1+coef every sample
+		inline void geometricChunk(float* vals,float start,const float* gp,bool fromOne)
+		{
+			typedef SimdFloat F;
+			for(int j = 0 ; j < Chunk;j+=F::Lanes)
+			{
+				F x = F::load(gp+j)*start;
+				if(fromOne)
+					x = 1.0f - x;
+				x.store(vals+j);
+			}
+		}
+		//true when processSample would leave the current state at a sample starting on v
+		inline bool leavesState(float v) const
+		{
+			switch(state)
+			{
+				case 1: return v - 1 > -0.1;
+				case 2: return v - sustain < 10e-6;
+				default: return !(v > 20e-6);
+			}
+		}
 public:
+	//samples per geometric kernel step, a multiple of the SIMD width
+	static const int Chunk = 16;
 	AdsrEnvelope()
 	{
 		uf = 1;
@@ -43,6 +79,7 @@ public:
 		coef = 0;
 		state = 5;
 		SampleRate = 44000;
+		updateCoefs();
 	}
 	void ResetEnvelopeState()
 	{
@@ -52,6 +89,7 @@ public:
 	void setSampleRate(float sr)
 	{
 		SampleRate = sr;
+		updateCoefs();
 	}
 	void setUniqueDeriviance(float der)
 	{
@@ -65,6 +103,7 @@ public:
 	{
 		ua = atk;
 		attack = atk*uf;
+		updateCoefs();
 		if(state == 1)
 			coef = (float)((log(0.001) - log(1.3)) / (SampleRate * (atk) / 1000));
 	}
@@ -72,15 +111,17 @@ public:
 	{
 		ud = dec;
 		decay = dec*uf;
+		updateCoefs();
 		if(state == 2)
-			coef = (float)((log(jmin(sustain + 0.0001,0.99)) - log(1.0)) / (SampleRate * (dec) / 1000));
+			coef = (float)((logSustain - log(1.0)) / (SampleRate * (dec) / 1000));
 	}
 	void setSustain(float sust)
 	{
 		us = sust;
 		sustain = sust;
+		updateCoefs();
 		if(state == 2)
-			coef = (float)((log(jmin(sustain + 0.0001,0.99)) - log(1.0)) / (SampleRate * (decay) / 1000));
+			coef = decayCoef;
 	}
 	void setRelease(float rel)
 	{
@@ -93,7 +134,7 @@ public:
         {
             state = 1;
             //Value = Value +0.00001f;
-            coef = (float)((log(0.001) - log(1.3)) / (SampleRate * (attack)/1000 ));
+            coef = attackCoef;
         }
     void triggerRelease()
         {
@@ -105,6 +146,17 @@ public:
 	{
 		return state!=5;
 	}
+	inline bool isReleasing() const
+	{
+		return state == 4;
+	}
+	//samples the release still needs to fall silent, 0 outside of it
+	inline int releaseRemaining() const
+	{
+		if(state != 4 || !(Value > 20e-6) || coef >= 0)
+			return 0;
+		return (int)(log(20e-6 / Value) / log1p((double)coef));
+	}
 	inline float processSample()
         {
             switch (state)
@@ -114,7 +166,7 @@ public:
                     {
                         Value = jmin(Value, 0.99f);
                         state = 2;
-                        coef = (float)((log(jmin(sustain + 0.0001, 0.99)) - log(1.0)) / (SampleRate * (decay) / 1000));
+                        coef = decayCoef;
 						goto dec;
                     }
 					else
@@ -147,4 +199,97 @@ public:
 			return Value;
         }
 
+	//Writes samples of the current state for as long as it lasts, at most n
+	//Returns how many were written, the sample that changes the state is left to processSample
+	//Stages are geometric series, Chunk values at a time come from powers of g
+	//instead of the recursion, they match processSample within float rounding
+	//and may change state a sample apart when a value lands on the threshold
+	inline int processSpan(float* out,int n)
+	{
+		if(state == 3 || state == 5)
+		{
+			const float v = state == 3 ? jmin(sustain, 0.9f) : 0.0f;
+			for(int i = 0 ; i < n;i++)
+				out[i] = v;
+			Value = v;
+			return n;
+		}
+		if(leavesState(Value))
+			return 0;
+		//a float recursion with steps this small drifts from the exponential it stands for,
+		//slow stages keep the recursion so they stay identical to processSample
+		if(fabsf(coef) < 3e-5f)
+		{
+			int i = 0;
+			while(i < n && !leavesState(Value))
+			{
+				if(state == 1)
+					Value = Value - (1-Value)*(coef);
+				else if(state == 2)
+					Value =Value + Value * coef;
+				else
+					Value = Value + Value * coef + dc;
+				out[i++] = Value;
+			}
+			return i;
+		}
+		const bool fromOne = state == 1;
+		//g and its powers in double, 1+coef rounded to float would drift over long stages
+		const double g = 1.0 + coef;
+		double gd = g;
+		float gp[Chunk];
+		for(int j = 0 ; j < Chunk;j++)
+		{
+			gp[j] = (float)gd;
+			gd *= g;
+		}
+		const double gChunk = gd / g;
+		float vals[Chunk];
+		//distance to 1 in attack, keeps its precision where the value does not
+		double start = fromOne ? 1 - Value : Value;
+		int done = 0;
+		while(done < n)
+		{
+			geometricChunk(vals,(float)start,gp,fromOne);
+			const int m = jmin(Chunk,n-done);
+			//the stages are monotonic, one test tells whether the state ends inside the chunk
+			if(m > 1 && leavesState(vals[m-2]))
+			{
+				int j = 0;
+				do
+				{
+					out[done++] = Value = vals[j++];
+				}
+				while(!leavesState(Value));
+				return done;
+			}
+			for(int j = 0 ; j < m;j++)
+				out[done+j] = vals[j];
+			done += m;
+			Value = vals[m-1];
+			if(leavesState(Value))
+				return done;
+			start = start*gChunk;
+		}
+		return done;
+	}
+	//Same as n calls of processSample
+	//Returns the samples before the envelope fell silent, n if it did not or was silent already
+	inline int processBlock(float* out,int n)
+	{
+		int active = state == 5 ? 0 : n;
+		int i = 0;
+		while(i < n)
+		{
+			i += processSpan(out+i,n-i);
+			if(i < n)
+			{
+				out[i++] = processSample();
+				if(state == 5 && active == n)
+					active = i;
+			}
+		}
+		return active;
+	}
+
 };
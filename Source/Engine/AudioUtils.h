@@ -30,6 +30,30 @@ const float sq2_12 = 1.0594630943592953f;
 const float dc = 1e-18;
 const float ln2 = 0.69314718056f;
 const float mult = ln2 / 12.0;
+//Precision tiers of the pitch exponential
+//Max error against a double reference over +-200 semitones around A440:
+//PITCH_EXACT expf, the default and reference, 0.002 cent
+//PITCH_HIGH 5th order polynomial, 0.002 cent (the polynomial alone is 0.00015)
+//PITCH_FAST 3rd order polynomial, 0.15 cent
+enum { PITCH_EXACT = 0, PITCH_HIGH = 1, PITCH_FAST = 2 };
+
+//2^f for f in [0,1), works on float and SimdFloat
+//p(0) = 1 so there is no step where octaves meet
+template<typename T> inline static T exp2Fraction(T f,int precision)
+{
+	if(precision == PITCH_FAST)
+		return ((0.077067064f*f + 0.22764495f)*f + 0.6951168f)*f + 1.0f;
+	return ((((0.0018671302f*f + 0.0090170298f)*f + 0.055799914f)*f + 0.24016445f)*f + 0.69315131f)*f + 1.0f;
+}
+//2^x with the integer part put straight into the exponent bits
+inline static float fastExp2(float x,int precision)
+{
+	x = jlimit(-126.0f,126.0f,x);
+	const float fl = floorf(x);
+	union { int32 i; float f; } scale;
+	scale.i = ((int32)fl + 127) << 23;
+	return scale.f * exp2Fraction(x - fl,precision);
+}
 inline static float getPitch(float index)
 {
 	//Lookup table is not that effective compared to SSE exp
@@ -51,6 +75,46 @@ inline static float getPitch(float index)
 	//
  // return lut[mi] + (lut[mi+1] - lut[mi]) * ofs;
 };
+inline static float getPitch(float index,int precision)
+{
+	if(precision == PITCH_EXACT)
+		return getPitch(index);
+	return 440 * fastExp2(index * (1.0f/12),precision);
+}
+//Precision tiers of the filter cutoff prewarp tan(pi*fc/fs)
+//Max relative error up to the SampleRate*0.5-120 cutoff clamp at 44.1 kHz:
+//PREWARP_EXACT tanf, the default and reference, 1.3e-5
+//PREWARP_HIGH Pade 5/4, 8.8e-6
+//PREWARP_FAST Pade 3/2, 2.1e-4 (0.4 cent of cutoff)
+enum { PREWARP_EXACT = 0, PREWARP_HIGH = 1, PREWARP_FAST = 2 };
+
+//numerator and denominator of tan(pi*w) for w in [-0.25,0.25], works on float and SimdFloat
+template<typename T> inline static void tanPiRatio(T w,int precision,T& num,T& den)
+{
+	const T w2 = w*w;
+	if(precision == PREWARP_FAST)
+	{
+		num = (-2.06708511f*w2 + 3.14159265f)*w;
+		den = -3.94784176f*w2 + 1.0f;
+		return;
+	}
+	num = ((0.323830354f*w2 - 3.44514185f)*w2 + 3.14159265f)*w;
+	den = (1.54617605f*w2 - 4.38649084f)*w2 + 1.0f;
+}
+//tan(pi*w) for w in [-0.25,0.5)
+//above 0.25 it is the cotangent of 0.5-w, which is exact in float near the pole
+//and so ends up more accurate than tanf of the rounded angle
+inline static float fastTanPi(float w,int precision)
+{
+	float num,den;
+	if(w > 0.25f)
+	{
+		tanPiRatio(0.5f - w,precision,num,den);
+		return den / num;
+	}
+	tanPiRatio(w,precision,num,den);
+	return num / den;
+}
 
 inline static float tptlpupw(float & state , float inp , float cutoff , float srInv)
 {
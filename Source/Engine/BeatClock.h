@@ -0,0 +1,99 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <math.h>
+//Beat position that keeps running between host blocks
+//The host position is only taken over when the transport starts or jumps, loop points included
+//Smaller differences, tempo ramps and position rounding, are caught up by the rate of the next block
+//A tempo ramp is extrapolated from the tempo change over the last block
+class BeatClock
+{
+private:
+	double beat;
+	double beatsPerSample;
+	//host tempo in beats per sample at the start of the last block
+	double lastTempoRate;
+	double sampleRate;
+	int lastSamples;
+	bool wasPlaying;
+public:
+	BeatClock()
+	{
+		beat = 0;
+		beatsPerSample = 0;
+		lastTempoRate = 0;
+		sampleRate = 44100;
+		lastSamples = 0;
+		wasPlaying = false;
+	}
+	void setSampleRate(double sr)
+	{
+		sampleRate = sr;
+	}
+	//call once per host block with the position at its start
+	//returns true when the clock was set to the host position
+	bool update(double bpm,double ppq,bool playing,int numSamples)
+	{
+		//further off than this is a locate or a loop, nearer is drift
+		const double jumpBeats = 1.0/16;
+		const double predicted = beat + beatsPerSample*lastSamples;
+		const double tempoRate = bpm / (60*sampleRate);
+		bool jumped = false;
+		if(!playing)
+		{
+			//hosts hold the position while stopped, the clock runs on at the tempo
+			beat = predicted;
+			beatsPerSample = tempoRate;
+		}
+		else if(!wasPlaying || fabs(ppq - predicted) > jumpBeats)
+		{
+			beat = ppq;
+			beatsPerSample = tempoRate;
+			jumped = true;
+		}
+		else if(numSamples > 0)
+		{
+			//aim at where the host will be at the end of this block
+			const double slope = lastSamples > 0 ? (tempoRate - lastTempoRate) / lastSamples : 0;
+			const double target = ppq + (tempoRate + 0.5*slope*numSamples)*numSamples;
+			beat = predicted;
+			beatsPerSample = (target - predicted) / numSamples;
+		}
+		else
+			beat = predicted;
+		lastTempoRate = tempoRate;
+		wasPlaying = playing;
+		lastSamples = numSamples;
+		return jumped;
+	}
+	//beat at the start of the last updated block
+	double getBeat() const
+	{
+		return beat;
+	}
+	float getBeatsPerSecond() const
+	{
+		return (float)(beatsPerSample*sampleRate);
+	}
+};
@@ -0,0 +1,131 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <stdint.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+//Fixed size bit set with find first set, used for voice and key bookkeeping
+template<int Bits> class BitSet
+{
+private:
+	const static int Words = (Bits + 31) / 32;
+	uint32_t w[Words];
+	static inline int lowestBit(uint32_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long r;
+		_BitScanForward(&r,x);
+		return (int)r;
+#else
+		return __builtin_ctz(x);
+#endif
+	}
+	static inline int highestBit(uint32_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long r;
+		_BitScanReverse(&r,x);
+		return (int)r;
+#else
+		return 31 - __builtin_clz(x);
+#endif
+	}
+public:
+	BitSet()
+	{
+		clearAll();
+	}
+	inline void set(int i) { w[i>>5] |= 1u << (i&31); }
+	inline void clear(int i) { w[i>>5] &= ~(1u << (i&31)); }
+	inline bool test(int i) const { return (w[i>>5] >> (i&31)) & 1; }
+	inline void setTo(int i,bool v) { if(v) set(i); else clear(i); }
+	inline void clearAll()
+	{
+		for(int i = 0 ; i < Words;i++)
+			w[i] = 0;
+	}
+	//sets bits [0,count)
+	inline void setFirst(int count)
+	{
+		for(int i = 0 ; i < count;i++)
+			set(i);
+	}
+	//lowest set bit at or after from, Bits when there is none
+	inline int findNext(int from) const
+	{
+		if(from >= Bits)
+			return Bits;
+		int k = from>>5;
+		uint32_t x = w[k] & (~0u << (from&31));
+		while(x == 0)
+		{
+			if(++k == Words)
+				return Bits;
+			x = w[k];
+		}
+		return (k<<5) + lowestBit(x);
+	}
+	//lowest clear bit at or after from, Bits when there is none
+	inline int findNextClear(int from) const
+	{
+		if(from >= Bits)
+			return Bits;
+		int k = from>>5;
+		uint32_t x = ~w[k] & (~0u << (from&31));
+		while(x == 0)
+		{
+			if(++k == Words)
+				return Bits;
+			x = ~w[k];
+		}
+		int r = (k<<5) + lowestBit(x);
+		return r < Bits ? r : Bits;
+	}
+	inline bool isEmpty() const
+	{
+		for(int i = 0 ; i < Words;i++)
+			if(w[i])
+				return false;
+		return true;
+	}
+	friend inline BitSet operator&(BitSet a,const BitSet& b)
+	{
+		for(int i = 0 ; i < Words;i++)
+			a.w[i] &= b.w[i];
+		return a;
+	}
+	inline int findFirst() const
+	{
+		return findNext(0);
+	}
+	//highest set bit, -1 when there is none
+	inline int findLast() const
+	{
+		for(int k = Words-1 ; k >= 0;k--)
+			if(w[k])
+				return (k<<5) + highestBit(w[k]);
+		return -1;
+	}
+};
@@ -0,0 +1,104 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include "BlepData.h"
+#include "SimdFloat.h"
+//Blep and blamp tables rearranged per fractional phase
+//Row r holds the taps table[r + i*B_OVERSAMPLING] of one transition, so mixing it in
+//is a contiguous multiply-add instead of a strided gather
+class BlepTable
+{
+public:
+	static const int Taps = Samples*2;
+	//the offset of a transition can be exactly 1, its second tap reads one row further
+	static const int Rows = B_OVERSAMPLING + 2;
+	float rows[Rows][Taps];
+	//residual bleps are subtracted from the second half on, the sign is folded into the rows
+	BlepTable(const float* table,bool residual)
+	{
+		const int length = Taps*B_OVERSAMPLING + 1;
+		for(int r = 0 ; r < Rows;r++)
+		{
+			for(int i = 0 ; i < Taps;i++)
+			{
+				const int idx = r + i*B_OVERSAMPLING;
+				const float v = idx < length ? table[idx] : 0;
+				rows[r][i] = (residual && i >= Samples) ? -v : v;
+			}
+		}
+	}
+	static const BlepTable& getBlep() { static const BlepTable t(blep,true); return t; }
+	static const BlepTable& getBlepD2() { static const BlepTable t(blepd2,true); return t; }
+	static const BlepTable& getBlamp() { static const BlepTable t(blamp,false); return t; }
+	static const BlepTable& getBlampD2() { static const BlepTable t(blampd2,false); return t; }
+};
+
+//Pending transition residuals of one oscillator
+//Kept linear instead of as a masked ring, the window slides down once every Taps samples,
+//so every mix writes Taps contiguous floats
+class BlepBuffer
+{
+	typedef SimdFloat F;
+	static const int Taps = BlepTable::Taps;
+	float buf[Taps*2];
+	int pos;
+public:
+	BlepBuffer()
+	{
+		for(int i = 0 ; i < Taps*2;i++)
+			buf[i] = 0;
+		pos = 0;
+	}
+	//same values and summation order as interpolating the two taps per sample
+	inline void mixIn(const BlepTable& table,float offset,float scale)
+	{
+		int lpIn =(int)(B_OVERSAMPLING*(offset));
+		float frac = offset * B_OVERSAMPLING - lpIn;
+		float f1 = 1.0f-frac;
+		const float* a = table.rows[lpIn];
+		const float* b = table.rows[lpIn+1];
+		float* out = buf + pos;
+		for(int i = 0 ; i < Taps;i+=F::Lanes)
+		{
+			F mixvalue = F::load(a+i)*f1 + F::load(b+i)*frac;
+			(F::load(out+i) + mixvalue*scale).store(out+i);
+		}
+	}
+	//clears the current sample and returns the next one
+	inline float next()
+	{
+		buf[pos] = 0.0f;
+		pos++;
+		if(pos == Taps)
+		{
+			for(int i = 0 ; i < Taps;i++)
+			{
+				buf[i] = buf[i+Taps];
+				buf[i+Taps] = 0;
+			}
+			pos = 0;
+		}
+		return buf[pos];
+	}
+};
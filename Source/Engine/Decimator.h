@@ -1,86 +1,234 @@
 #pragma once
+#include "SimdFloat.h"
 //MusicDsp 
 // T.Rochebois
 //still indev
-class Decimator17
+//Half band decimators, left and right at once
+//In polyphase form the even input phase runs through the odd taps and the odd
+//phase through the center tap only, the zero even taps are skipped.
+//Lanes compute consecutive outputs, each adds its taps oldest first like the
+//per sample transposed form did, so the result is the same to the bit.
+//K odd taps per side, 9 for the 17 tap filter and 5 for the 9 tap one
+template<int K> class HalfBandFir
 {
+	typedef SimdFloat F;
+public:
+	const static int MAX_OUT = 64;
 private:
-	const float h0,h1,h3,h5,h7,h9,h11,h13,h15,h17;
-	float R1,R2,R3,R4,R5,R6,R7,R8,R9,R10,R11,R12,R13,R14,R15,R16,R17;
+	const static int HIST = 2*K-1;
+	//tap per age of an even phase sample and the center tap
+	float taps[2*K];
+	float h0;
+	//history followed by the current block, per channel
+	float even[2][HIST+MAX_OUT];
+	float odd[2][K+MAX_OUT];
+	static const float* oddTaps()
+	{
+		static const float t17[9] = { 0.314356238f,-0.0947515890f,0.0463142134f,-0.0240881704f,0.0120250406f,
+			-0.00543170841f,0.00207426259f,-0.000572688237f,5.18944944e-005f };
+		static const float t9[5] = { 5042/16384.0f,-1277/16384.0f,429/16384.0f,-116/16384.0f,18/16384.0f };
+		return K == 9 ? t17 : t9;
+	}
+	inline float calc(const float* e,const float* o) const
+	{
+		float acc = taps[2*K-1]*e[-(2*K-1)];
+		for(int a = 2*K-2 ; a >= 0;a--)
+		{
+			acc = acc + taps[a]*e[-a];
+			if(a == K)
+				acc = acc + h0*o[-K];
+		}
+		return acc;
+	}
+	//both channels at once, the two sums hide each other's add latency
+	inline void calc(const float* el,const float* ol,const float* er,const float* or_,float* yl,float* yr) const
+	{
+		F accl = taps[2*K-1]*F::load(el-(2*K-1));
+		F accr = taps[2*K-1]*F::load(er-(2*K-1));
+		for(int a = 2*K-2 ; a >= 0;a--)
+		{
+			accl = accl + taps[a]*F::load(el-a);
+			accr = accr + taps[a]*F::load(er-a);
+			if(a == K)
+			{
+				accl = accl + h0*F::load(ol-K);
+				accr = accr + h0*F::load(or_-K);
+			}
+		}
+		accl.store(yl);
+		accr.store(yr);
+	}
+	//n <= MAX_OUT outputs
+	void processPiece(float* l,float* r,float* yl,float* yr,int n)
+	{
+		float* el = even[0];
+		float* er = even[1];
+		float* ol = odd[0];
+		float* or_ = odd[1];
+		for(int i = 0 ; i < n;i++)
+		{
+			el[HIST+i] = l[2*i];
+			ol[K+i] = l[2*i+1];
+			er[HIST+i] = r[2*i];
+			or_[K+i] = r[2*i+1];
+		}
+		int i = 0;
+		for(; i + F::Lanes <= n;i+=F::Lanes)
+			calc(el+HIST+i,ol+K+i,er+HIST+i,or_+K+i,yl+i,yr+i);
+		for(; i < n;i++)
+		{
+			yl[i] = calc(el+HIST+i,ol+K+i);
+			yr[i] = calc(er+HIST+i,or_+K+i);
+		}
+		for(int j = 0 ; j < HIST;j++)
+		{
+			el[j] = el[n+j];
+			er[j] = er[n+j];
+		}
+		for(int j = 0 ; j < K;j++)
+		{
+			ol[j] = ol[n+j];
+			or_[j] = or_[n+j];
+		}
+	}
 public:
-	Decimator17()
-		: h0(0.5)
-		, h1(0.314356238)
-		, h3(-0.0947515890)
-		, h5(0.0463142134)
-		, h7(-0.0240881704)
-		, h9(0.0120250406)
-		, h11(-0.00543170841)
-		, h13(0.00207426259)
-		, h15(-0.000572688237)
-		, h17(5.18944944e-005)
+	HalfBandFir()
 	{
-		R1=R2=R3=R4=R5=R6=R7=R8=R9=R10=R11=R12=R13=R14=R15=R16=R17=0;
+		const float* t = oddTaps();
+		for(int a = 0 ; a < K;a++)
+		{
+			taps[a] = t[K-1-a];
+			taps[K+a] = t[a];
+		}
+		h0 = 0.5f;
+		for(int c = 0 ; c < 2;c++)
+		{
+			for(int i = 0 ; i < HIST+MAX_OUT;i++)
+				even[c][i] = 0;
+			for(int i = 0 ; i < K+MAX_OUT;i++)
+				odd[c][i] = 0;
+		}
 	}
-	float Calc(const float x0,const float x1)
+	//l and r hold 2*numOut samples, the first numOut are replaced by the output
+	void process(float* l,float* r,int numOut)
 	{
-		float h17x0 = h17 *x0;
-		float h15x0 = h15 *x0;
-		float h13x0 = h13 *x0;
-		float h11x0=  h11 *x0;
-		float h9x0=h9*x0;
-		float h7x0=h7*x0;
-		float h5x0=h5*x0;
-		float h3x0=h3*x0;
-		float h1x0=h1*x0;
-		float R18=R17+h17x0;
-		R17 = R16 + h15x0;
-		R16 = R15 + h13x0;
-		R15 = R14 + h11x0;
-		R14 = R13 + h9x0;
-		R13 = R12 + h7x0;
-		R12 = R11 + h5x0;
-		R11 = R10 + h3x0;
-		R10 = R9  + h1x0;
-		R9  = R8  + h1x0 + h0*x1;
-		R8  = R7  + h3x0;
-		R7  = R6  + h5x0;
-		R6  = R5  + h7x0;
-		R5  = R4  + h9x0;
-		R4  = R3  + h11x0;
-		R3  = R2  + h13x0;
-		R2  = R1  + h15x0;
-		R1  = h17x0;
-		return R18;
+		//the input of a piece is copied before its output is written,
+		//output i never reaches input 2*i of a later piece
+		for(int i = 0 ; i < numOut;i+=MAX_OUT)
+			processPiece(l+2*i,r+2*i,l+i,r+i,numOut-i < MAX_OUT ? numOut-i : MAX_OUT);
 	}
 };
-class Decimator9
+//Polyphase IIR half band, two branches of first order allpass sections at the output rate
+//Much lower latency than the FIR at the cost of phase linearity
+//The sections are one long dependency chain, plain arrays over the four chains
+//of both branches and channels vectorize better than lane loads would
+class HalfBandIir
 {
+	const static int SECTIONS = 4;
+	const static int CHAINS = 4;
+	float coefs[SECTIONS][CHAINS];
+	float xs[SECTIONS][CHAINS];
+	float ys[SECTIONS][CHAINS];
+public:
+	HalfBandIir()
+	{
+		//later phase through branch a, earlier through branch b
+		//order 8 set from the MusicDsp polyphase filter archive, 0.01 transition band
+		const float a[SECTIONS] = { 0.07711507983241622f,0.4820706250610472f,0.7968204713315797f,0.9412514277740471f };
+		const float b[SECTIONS] = { 0.2659685265210946f,0.6651041532634957f,0.8841015085506159f,0.9820054141886075f };
+		for(int s = 0 ; s < SECTIONS;s++)
+		{
+			for(int c = 0 ; c < CHAINS;c++)
+			{
+				coefs[s][c] = (c & 1) ? b[s] : a[s];
+				xs[s][c] = ys[s][c] = 0;
+			}
+		}
+	}
+	//l and r hold 2*numOut samples, the first numOut are replaced by the output
+	void process(float* l,float* r,int numOut)
+	{
+		for(int i = 0 ; i < numOut;i++)
+		{
+			float v[CHAINS] = { l[2*i+1],l[2*i],r[2*i+1],r[2*i] };
+			for(int s = 0 ; s < SECTIONS;s++)
+			{
+				for(int c = 0 ; c < CHAINS;c++)
+				{
+					float out = xs[s][c] + coefs[s][c]*(v[c] - ys[s][c]);
+					xs[s][c] = v[c];
+					ys[s][c] = out;
+					v[c] = out;
+				}
+			}
+			l[i] = 0.5f*(v[0]+v[1]);
+			r[i] = 0.5f*(v[2]+v[3]);
+		}
+		//the sections decay through denormals after the input stops
+		for(int s = 0 ; s < SECTIONS;s++)
+		{
+			for(int c = 0 ; c < CHAINS;c++)
+			{
+				if(fabsf(xs[s][c]) < 1e-20f)
+					xs[s][c] = 0;
+				if(fabsf(ys[s][c]) < 1e-20f)
+					ys[s][c] = 0;
+			}
+		}
+	}
+};
+enum
+{
+	//17 tap FIR for the last stage, 9 tap for the earlier ones
+	DECIMATOR_FIR = 0,
+	//9 tap FIR for every stage
+	DECIMATOR_FIR_CHEAP,
+	//allpass polyphase IIR for every stage, lowest latency
+	DECIMATOR_IIR
+};
+//Half band stages in cascade, decimates factor samples to one
+//Early stages run at the higher rates where the 9 tap filter is enough,
+//the last one sets the passband edge
+class DecimatorChain
+{
+public:
+	const static int MAX_FACTOR = 8;
 private:
-	const float h0,h1,h3,h5,h7,h9;
-	float R1,R2,R3,R4,R5,R6,R7,R8,R9;
+	HalfBandFir<5> early[2];
+	HalfBandFir<9> last;
+	HalfBandFir<5> lastCheap;
+	HalfBandIir iir[3];
+	int stages;
+	int type;
 public:
-	Decimator9() : h0(8192/16384.0f),h1(5042/16384.0f),h3(-1277/16384.0f),h5(429/16384.0f),h7(-116/16384.0f),h9(18/16384.0f)
+	DecimatorChain()
+	{
+		stages = 0;
+		type = DECIMATOR_FIR;
+	}
+	//factor is 1, 2, 4 or 8
+	void setFactor(int factor,int decimator)
 	{
-		R1=R2=R3=R4=R5=R6=R7=R8=R9=0.0f;
+		stages = 0;
+		while((2<<stages) <= factor && (2<<stages) <= MAX_FACTOR)
+			stages++;
+		type = decimator;
 	}
-	inline float Calc(const float x0,const float x1)
+	//l and r hold numOut*factor samples in time order,
+	//the first numOut are replaced by the output, the rest is used as scratch
+	void process(float* l,float* r,int numOut)
 	{
-		float h9x0=h9*x0;
-		float h7x0=h7*x0;
-		float h5x0=h5*x0;
-		float h3x0=h3*x0;
-		float h1x0=h1*x0;
-		float R10=R9+h9x0;
-		R9=R8+h7x0;
-		R8=R7+h5x0;
-		R7=R6+h3x0;
-		R6=R5+h1x0;
-		R5=R4+h1x0+h0*x1;
-		R4=R3+h3x0;
-		R3=R2+h5x0;
-		R2=R1+h7x0;
-		R1=h9x0;
-		return R10;
+		for(int s = 0 ; s < stages;s++)
+		{
+			const int n = numOut<<(stages-1-s);
+			if(type == DECIMATOR_IIR)
+				iir[s].process(l,r,n);
+			else if(s < stages-1)
+				early[s].process(l,r,n);
+			else if(type == DECIMATOR_FIR_CHEAP)
+				lastCheap.process(l,r,n);
+			else
+				last.process(l,r,n);
+		}
 	}
 };
@@ -24,48 +24,49 @@
 #pragma once
 #include "SynthEngine.h"
 //Always feed first then get delayed sample!
-#define DEMAX 64
+//The output is DM-1 feeds old, the ring holds exactly DM samples
 template<unsigned int DM> class DelayLine
 {
 private:
-	float dl[DEMAX];
+	static_assert((DM & (DM-1)) == 0,"DelayLine length has to be a power of two");
+	float dl[DM];
 	int iidx;
 public:
 		DelayLine() 
 	{
 		iidx = 0;
-		zeromem(dl,sizeof(float)*DEMAX);
-		//jassert(DM > DMAX);
+		zeromem(dl,sizeof(float)*DM);
 	}
 	inline float feedReturn(float sm)
 	{
 		dl[iidx] = sm;
 		iidx--;
-		iidx=(iidx&(DEMAX-1));
-		return dl[(iidx + DM)&(DEMAX-1)];
+		iidx=(iidx&(DM-1));
+		return dl[(iidx + DM)&(DM-1)];
 	}
 	inline void fillZeroes()
 	{
-		zeromem(dl,DEMAX*sizeof(float));
+		zeromem(dl,DM*sizeof(float));
 	}
 };
 template<unsigned int DM> class DelayLineBoolean
 {
 private:
-	bool dl[DEMAX];
+	static_assert((DM & (DM-1)) == 0,"DelayLine length has to be a power of two");
+	bool dl[DM];
 	int iidx;
 public:
 		DelayLineBoolean() 
 	{
 		iidx = 0;
-		zeromem(dl,sizeof(bool)*DEMAX);
+		zeromem(dl,sizeof(bool)*DM);
 	}
 		inline float feedReturn(bool sm)
 	{
 		dl[iidx] = sm;
 		iidx--;
-		iidx=(iidx&(DEMAX-1));
-		return dl[(iidx + DM)&(DEMAX-1)];
+		iidx=(iidx&(DM-1));
+		return dl[(iidx + DM)&(DM-1)];
 	}
 
 };
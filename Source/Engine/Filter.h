@@ -36,6 +36,39 @@ private:
 	//24 db multimode
 	float mmt;
 	int mmch;
+	//multimode as output weights, worked out when the mode parameters change
+	//12 db: low pass and notch weights, band pass blend of y2, y1 and v
+	float mixY2,mixV;
+	double bpY2,bpV;
+	float bpY1;
+	//24 db: two weighted cascade outputs, index 0 is y1
+	float mix4A,mix4B;
+	int mix4IdxA,mix4IdxB;
+
+	bool fourPole;
+	typedef float (Filter::*Kernel)(float,float);
+	Kernel kernel;
+	void updateKernel()
+	{
+		if(fourPole)
+			kernel = &Filter::Apply4Pole;
+		else if(bandPassSw)
+			kernel = selfOscPush ? &Filter::Apply<true,true> : &Filter::Apply<true,false>;
+		else
+			kernel = selfOscPush ? &Filter::Apply<false,true> : &Filter::Apply<false,false>;
+	}
+
+	//prewarp tier and how many samples each computed coefficient covers
+	int prewarpPrecision;
+	int coefInterval;
+	float coefIntervalInv;
+	//gain ramp between coefficient updates
+	float gRamp,gStep;
+	int coefCount;
+	//the next update jumps to the coefficient instead of ramping from a stale one
+	bool coefSnap;
+
+	friend class FilterBank;
 public:
 	float SampleRate;
 	float sampleRateInv;
@@ -46,7 +79,8 @@ public:
 	{
 		selfOscPush = false;
 		bandPassSw = false;
-		mm=0;
+		fourPole = false;
+		setMultimode(0);
 		s1=s2=s3=s4=0;
 		SampleRate = 44000;
 		sampleRateInv = 1 / SampleRate;
@@ -56,12 +90,79 @@ public:
 		rcor24Inv = 1 / rcor24;
 		R=1;
 		R24=0;
+		updateKernel();
+		prewarpPrecision = PREWARP_EXACT;
+		coefInterval = 1;
+		coefIntervalInv = 1;
+		gRamp = gStep = 0;
+		coefCount = 0;
+		coefSnap = true;
+	}
+	//precision is one of the PREWARP_ tiers from AudioUtils.h
+	//with an interval above 1 the coefficient is computed every interval samples
+	//and ramped linearly towards it, so it lags the cutoff by one interval
+	void setPrewarp(int precision,int interval)
+	{
+		prewarpPrecision = precision;
+		coefInterval = jlimit(1,32,interval);
+		coefIntervalInv = 1.0f / coefInterval;
+		snapCoefficient();
+	}
+	//on note on, the ramp restarts at the current cutoff
+	void snapCoefficient()
+	{
+		coefCount = 0;
+		coefSnap = true;
 	}
 	void setMultimode(float m)
 	{
 		mm = m;
 		mmch = (int)(mm * 3);
 		mmt = mm*3-mmch;
+		mixY2 = 1-mm;
+		mixV = mm;
+		//the band pass crossfades y2 to y1 below mm 0.5 and y1 to v above it
+		bpY2 = mm < 0.5 ? 0.5 - mm : 0;
+		bpY1 = mm < 0.5 ? mm : 1-mm;
+		bpV = mm < 0.5 ? 0 : mm - 0.5;
+		//mmch 0 blends y4 with y3, 1 y3 with y2, 2 y2 with y1, 3 is y1 alone
+		if(mmch >= 0 && mmch < 3)
+		{
+			mix4IdxA = 3 - mmch;
+			mix4IdxB = 2 - mmch;
+			mix4A = 1 - mmt;
+			mix4B = mmt;
+		}
+		else
+		{
+			mix4IdxA = mix4IdxB = 0;
+			mix4A = mmch == 3 ? 1.0f : 0.0f;
+			mix4B = 0;
+		}
+	}
+	void setFourPole(bool on)
+	{
+		fourPole = on;
+		updateKernel();
+	}
+	void setBandPass(bool on)
+	{
+		bandPassSw = on;
+		updateKernel();
+	}
+	void setSelfOscPush(bool on)
+	{
+		selfOscPush = on;
+		updateKernel();
+	}
+	bool isFourPole() const
+	{
+		return fourPole;
+	}
+	//runs the variant picked for the current pole count, band pass and self oscillation push
+	inline float process(float sample,float g)
+	{
+		return (this->*kernel)(sample,g);
 	}
 	inline void setSampleRate(float sr)
 	{
@@ -79,18 +180,48 @@ public:
 		R24 =( 3.5 * res);
 	}
 	
+	//tan(pi*cutoff/fs), the double precision tan of the 24db path is kept for the exact tier
+	inline float tanCutoff(float cutoff,bool fourPole)
+	{
+		if(prewarpPrecision != PREWARP_EXACT)
+			return fastTanPi(cutoff*sampleRateInv,prewarpPrecision);
+		if(fourPole)
+			return (float)tan(cutoff *sampleRateInv * juce::float_Pi);
+		return tanf(cutoff *sampleRateInv * juce::float_Pi);
+	}
+	inline float prewarp(float cutoff,bool fourPole)
+	{
+		if(coefInterval == 1)
+			return tanCutoff(cutoff,fourPole);
+		if(coefCount == 0)
+		{
+			coefCount = coefInterval;
+			const float target = tanCutoff(cutoff,fourPole);
+			if(coefSnap)
+			{
+				gRamp = target;
+				gStep = 0;
+				coefSnap = false;
+			}
+			else
+				gStep = (target - gRamp) * coefIntervalInv;
+		}
+		coefCount--;
+		gRamp += gStep;
+		return gRamp;
+	}
 	inline float diodePairResistanceApprox(float x)
 	{
 		return (((((0.0103592f)*x + 0.00920833f)*x + 0.185f)*x + 0.05f )*x + 1.0f);
 		//Taylor approx of slightly mismatched diode pair
 	}
 	//resolve 0-delay feedback
-	inline float NR(float sample, float g)
+	template<bool SelfOscPush> inline float NR(float sample, float g)
 	{ 
 		//calculating feedback non-linear transconducance and compensated for R (-1)
 		//Boosting non-linearity
 		float tCfb;
-		if(!selfOscPush)
+		if(!SelfOscPush)
 			tCfb = diodePairResistanceApprox(s1*0.0876f) - 1.0f;
 		else
 			tCfb = diodePairResistanceApprox(s1*0.0876f) - 1.035f;
@@ -104,13 +235,13 @@ public:
 
 		return y;
 	}
-	inline float Apply(float sample,float g)
+	template<bool BandPass,bool SelfOscPush> inline float Apply(float sample,float g)
         {
 			
-			float gpw = tanf(g *sampleRateInv * juce::float_Pi);
+			float gpw = prewarp(g,false);
 			g = gpw;
             //float v = ((sample- R * s1*2 - g2*s1 - s2)/(1+ R*g1*2 + g1*g2));
-			float v = NR(sample,g);
+			float v = NR<SelfOscPush>(sample,g);
 
             float y1 = v*g + s1;
             s1 = v*g + y1;
@@ -119,15 +250,12 @@ public:
 			s2 = y1*g + y2;
 
             float mc;
-			if(!bandPassSw)
-            mc = (1-mm)*y2 + (mm)*v;
+			if(!BandPass)
+            mc = mixY2*y2 + mixV*v;
 			else
 			{
-
-				mc =2 * ( mm < 0.5 ? 
-					((0.5 - mm) * y2 + (mm) * y1):
-					((1-mm) * y1 + (mm-0.5) * v)
-						);
+				//the weight of the unused output is 0, so this matches the two term blends
+				mc =2 * ( bpY2 * y2 + (bpY1 * y1) + bpV * v);
 			}
 
 			return mc;
@@ -142,7 +270,7 @@ public:
 	}
 	inline float Apply4Pole(float sample,float g)
 	{
-			float g1 = (float)tan(g *sampleRateInv * juce::float_Pi);
+			float g1 = prewarp(g,true);
 			g = g1;
 
 
@@ -160,25 +288,8 @@ public:
 			float y2 = tptpc(s2,y1,g);
 			float y3 = tptpc(s3,y2,g);
 			float y4 = tptpc(s4,y3,g);
-			float mc;
-			switch(mmch)
-			{
-			case 0:
-				mc = ((1 - mmt) * y4 + (mmt) * y3);
-				break;
-			case 1:
-				mc = ((1 - mmt) * y3 + (mmt) * y2);
-				break;
-			case 2:
-				mc = ((1 - mmt) * y2 + (mmt) * y1);
-				break;
-			case 3:
-				mc = y1;
-				break;
-			default:
-				mc=0;
-				break;
-			}
+			const float ys[4] = { y1,y2,y3,y4 };
+			float mc = mix4A*ys[mix4IdxA] + mix4B*ys[mix4IdxB];
 			//half volume comp
 			return mc * (1 + R24 * 0.45);
 	}
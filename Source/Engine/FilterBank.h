@@ -0,0 +1,230 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright � 2013-2014 Filatov Vadim
+
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include "ObxdVoice.h"
+#include "SimdFloat.h"
+//Runs cutoff pitch, filter and amp of several voices at once, one voice per lane
+//Filter state stays in each voice, it is loaded at block start and stored back at block end
+//Mode and resonance are global parameters so all lanes share them
+class FilterBank
+{
+	typedef SimdFloat F;
+	typedef SimdDouble D;
+public:
+	static const int Lanes = SimdFloat::Lanes;
+	//inputs are interleaved by lane: in[sample*Lanes + lane]
+	static void process(ObxdVoice** voices,int count,const float* in,const float* cutIdx,const float* cutNoise,
+		const float* env,float** outs,int numSamples)
+	{
+		//all voices share the filter mode, the variant is picked once per group
+		const Filter& f = voices[0]->flt;
+		if(f.isFourPole())
+			process<true,false>(voices,count,in,cutIdx,cutNoise,env,outs,numSamples);
+		else if(f.bandPassSw)
+			process<false,true>(voices,count,in,cutIdx,cutNoise,env,outs,numSamples);
+		else
+			process<false,false>(voices,count,in,cutIdx,cutNoise,env,outs,numSamples);
+	}
+	//same result per lane as the scalar getPitch(index,precision)
+	static inline F getPitch(F index,int precision)
+	{
+		if(precision == PITCH_EXACT)
+			return index.map([](float x) { return ::getPitch(x); });
+		F x = F::max(F::min(index*(1.0f/12),126.0f),-126.0f);
+		F fl = F::floor(x);
+		return F::pow2i(fl) * exp2Fraction(x - fl,precision) * 440.0f;
+	}
+private:
+	template<bool FourPole,bool BandPass> static void process(ObxdVoice** voices,int count,const float* in,const float* cutIdx,const float* cutNoise,
+		const float* env,float** outs,int numSamples)
+	{
+		const Filter& f = voices[0]->flt;
+		const bool selfOscPush = voices[0]->selfOscPush;
+		const int precision = voices[0]->osc.pitchPrecision;
+		//at control rate the voices already return the cutoff in Hz
+		const bool controlRate = voices[0]->controlInterval > 1;
+		const float cutMax = f.SampleRate*0.5f-120.0f;
+		const int interval = f.coefInterval;
+		float st[4][Lanes];
+		//coefficient ramps, each lane keeps its own update phase
+		float ramp[Lanes],step[Lanes];
+		int counts[Lanes];
+		bool snaps[Lanes];
+		for(int l = 0 ; l < Lanes;l++)
+		{
+			const Filter& lf = voices[l < count ? l : 0]->flt;
+			st[0][l] = lf.s1;
+			st[1][l] = lf.s2;
+			st[2][l] = lf.s3;
+			st[3][l] = lf.s4;
+			ramp[l] = lf.gRamp;
+			step[l] = lf.gStep;
+			counts[l] = lf.coefCount;
+			snaps[l] = lf.coefSnap;
+		}
+		F s1 = F::load(st[0]),s2 = F::load(st[1]),s3 = F::load(st[2]),s4 = F::load(st[3]);
+		F g = F::load(ramp),gStep = F::load(step);
+		float o[Lanes];
+		for(int i = 0 ; i < numSamples;i++)
+		{
+			F cut = (controlRate ? F::load(cutIdx+i*Lanes) : getPitch(F::load(cutIdx+i*Lanes),precision)) + F::load(cutNoise+i*Lanes);
+			cut = F::min(cut,cutMax);
+			if(selfOscPush)
+				cut = F::min(cut,19000.0f);
+			if(interval == 1)
+				g = tanCutoff(f,cut,FourPole);
+			else
+			{
+				bool due = false;
+				for(int l = 0 ; l < Lanes;l++)
+					due |= counts[l] == 0;
+				if(due)
+				{
+					float t[Lanes];
+					tanCutoff(f,cut,FourPole).store(t);
+					g.store(ramp);
+					for(int l = 0 ; l < Lanes;l++)
+					{
+						if(counts[l] == 0)
+						{
+							counts[l] = interval;
+							if(snaps[l])
+							{
+								ramp[l] = t[l];
+								step[l] = 0;
+								snaps[l] = false;
+							}
+							else
+								step[l] = (t[l] - ramp[l]) * f.coefIntervalInv;
+						}
+					}
+					g = F::load(ramp);
+					gStep = F::load(step);
+				}
+				for(int l = 0 ; l < Lanes;l++)
+					counts[l]--;
+				g = g + gStep;
+			}
+			F x = F::load(in+i*Lanes);
+			if(FourPole)
+				x = apply4Pole(f,x,g,s1,s2,s3,s4);
+			else
+				x = apply<BandPass>(f,x,g,s1,s2);
+			x = x * F::load(env+i*Lanes);
+			x.store(o);
+			for(int l = 0 ; l < count;l++)
+				outs[l][i] = o[l];
+		}
+		s1.store(st[0]);
+		s2.store(st[1]);
+		s3.store(st[2]);
+		s4.store(st[3]);
+		g.store(ramp);
+		for(int l = 0 ; l < count;l++)
+		{
+			Filter& lf = voices[l]->flt;
+			lf.s1 = st[0][l];
+			lf.s2 = st[1][l];
+			lf.s3 = st[2][l];
+			lf.s4 = st[3][l];
+			if(interval != 1)
+			{
+				lf.gRamp = ramp[l];
+				lf.gStep = step[l];
+				lf.coefCount = counts[l];
+				lf.coefSnap = snaps[l];
+			}
+		}
+	}
+	//lane versions of Filter methods, keep the operation order in sync with them
+	static inline F tanCutoff(const Filter& f,F cut,bool fourpole)
+	{
+		if(f.prewarpPrecision != PREWARP_EXACT)
+		{
+			//same fold as fastTanPi
+			F w = cut*f.sampleRateInv;
+			F t = F::selectGreater(w,0.25f,0.5f - w,w);
+			F num,den;
+			tanPiRatio(t,f.prewarpPrecision,num,den);
+			return F::selectGreater(w,0.25f,den,num) / F::selectGreater(w,0.25f,num,den);
+		}
+		if(fourpole)
+			return (cut*f.sampleRateInv*juce::float_Pi).map([](float x) { return (float)tan(x); });
+		return (cut*f.sampleRateInv*juce::float_Pi).map([](float x) { return tanf(x); });
+	}
+	static inline F diodePairResistanceApprox(F x)
+	{
+		return (((((0.0103592f)*x + 0.00920833f)*x + 0.185f)*x + 0.05f )*x + 1.0f);
+	}
+	static inline F tptpc(F& state,F inp,F cutoff)
+	{
+		D v = D::from((inp - state) * cutoff / (1.0f + cutoff));
+		D res = v + D::from(state);
+		state = (res + v).toFloat();
+		return res.toFloat();
+	}
+	//g is the prewarped gain from tanCutoff
+	template<bool BandPass> static inline F apply(const Filter& f,F sample,F g,F& s1,F& s2)
+	{
+		//NR
+		F tCfb = diodePairResistanceApprox(s1*0.0876f) - (f.selfOscPush?1.035f:1.0f);
+		F rt = f.R+tCfb;
+		F v = ((sample - 2.0f*(s1*rt) - g*s1 - s2)/(1.0f + g*(2.0f*rt + g)));
+
+		F y1 = v*g + s1;
+		s1 = v*g + y1;
+
+		F y2 = y1*g + s2;
+		s2 = y1*g + y2;
+
+		if(!BandPass)
+			return f.mixY2*y2 + f.mixV*v;
+		return (2.0 * (f.bpY2 * D::from(y2) + D::from(f.bpY1 * y1) + f.bpV * D::from(v))).toFloat();
+	}
+	static inline F apply4Pole(const Filter& f,F sample,F g,F& s1,F& s2,F& s3,F& s4)
+	{
+		F lpc = g / (1.0f + g);
+		//NR24
+		F ml = 1.0f / (1.0f + g);
+		F S = (lpc*(lpc*(lpc*s1 + s2) + s3) + s4)*ml;
+		F G = lpc*lpc*lpc*lpc;
+		F y0 = (sample - f.R24 * S) / (1.0f + f.R24*G);
+		//first low pass in cascade
+		D v = D::from((y0 - s1) * lpc);
+		D res = v + D::from(s1);
+		s1 = (res + v).toFloat();
+		//damping
+		const float inv = f.rcor24Inv;
+		s1 = (s1*f.rcor24).map([inv](float x) -> float { return atan(x)*inv; });
+
+		F y1 = res.toFloat();
+		F y2 = tptpc(s2,y1,g);
+		F y3 = tptpc(s3,y2,g);
+		F y4 = tptpc(s4,y3,g);
+		const F ys[4] = { y1,y2,y3,y4 };
+		F mc = f.mix4A*ys[f.mix4IdxA] + f.mix4B*ys[f.mix4IdxB];
+		//half volume comp
+		return (D::from(mc) * (1 + f.R24 * 0.45)).toFloat();
+	}
+};
@@ -0,0 +1,131 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+//Indexed binary heap of midi keys ordered by an external priority table
+//MaxOnTop puts the highest priority on top, otherwise the lowest
+//Equal priorities go to the lower key, like a linear scan from key 0 would
+template<bool MaxOnTop> class KeyHeap
+{
+public:
+	const static int Keys = 129;
+private:
+	int heap[Keys];
+	int pos[Keys];
+	int count;
+	const int* priorities;
+	inline bool before(int a,int b) const
+	{
+		const int pa = priorities[a],pb = priorities[b];
+		if(pa != pb)
+			return MaxOnTop ? pa > pb : pa < pb;
+		return a < b;
+	}
+	inline void place(int i,int key)
+	{
+		heap[i] = key;
+		pos[key] = i;
+	}
+	void siftUp(int i)
+	{
+		const int key = heap[i];
+		while(i > 0)
+		{
+			const int parent = (i-1)>>1;
+			if(!before(key,heap[parent]))
+				break;
+			place(i,heap[parent]);
+			i = parent;
+		}
+		place(i,key);
+	}
+	void siftDown(int i)
+	{
+		const int key = heap[i];
+		for(;;)
+		{
+			int child = 2*i+1;
+			if(child >= count)
+				break;
+			if(child+1 < count && before(heap[child+1],heap[child]))
+				child++;
+			if(!before(heap[child],key))
+				break;
+			place(i,heap[child]);
+			i = child;
+		}
+		place(i,key);
+	}
+public:
+	KeyHeap(const int* prioritiesTable)
+	{
+		priorities = prioritiesTable;
+		count = 0;
+		for(int i = 0 ; i < Keys;i++)
+			pos[i] = -1;
+	}
+	inline bool contains(int key) const
+	{
+		return pos[key] >= 0;
+	}
+	//top key, Keys when empty
+	inline int top() const
+	{
+		return count > 0 ? heap[0] : Keys;
+	}
+	void insert(int key)
+	{
+		if(contains(key))
+			return;
+		place(count,key);
+		siftUp(count++);
+	}
+	void remove(int key)
+	{
+		if(!contains(key))
+			return;
+		const int i = pos[key];
+		pos[key] = -1;
+		if(i == --count)
+			return;
+		const int moved = heap[count];
+		place(i,moved);
+		siftUp(i);
+		siftDown(pos[moved]);
+	}
+	//call after the priority of key changed
+	void update(int key)
+	{
+		if(!contains(key))
+			return;
+		const int i = pos[key];
+		siftUp(i);
+		siftDown(pos[key]);
+	}
+	void clear()
+	{
+		for(int i = 0 ; i < count;i++)
+			pos[heap[i]] = -1;
+		count = 0;
+	}
+};
@@ -23,18 +23,29 @@
  */
 #pragma once
 #include "SynthEngine.h"
+#include "NoiseGen.h"
 class Lfo
 {
 private:
 	float phase;
 	float s, sq, sh;
 	float s1;
-    Random rg;
+    NoiseGen rg;
 	float SampleRate;
 	float SampleRateInv;
 
 	float syncRate;
 	bool synced;
+	//phase has to be realigned to the beat clock on the next hostSync
+	bool beatPending;
+
+	//sine phasor, rotated by the phase increment every sample
+	//it is recomputed from the phase every RESYNC samples so the two cannot drift apart
+	const static int RESYNC = 64;
+	double qc,qs;
+	double rotC,rotS;
+	float rotInc;
+	int resyncCount;
 
 public:
 	float Frequency;
@@ -49,29 +60,57 @@ public:
 		syncRate = 1;
 		rawParam=0;
 		synced = false;
+		beatPending = true;
 		s1=0;
 		Frequency=1;
 		phase=0;
 		s=sq=sh=0;
-		rg=Random();
+		qc=1;
+		qs=0;
+		rotC=1;
+		rotS=0;
+		rotInc=0;
+		resyncCount=0;
+		rg.seed(Random::getSystemRandom().nextInt64());
 	}
 	void setSynced()
 	{
 		synced = true;
+		beatPending = true;
 		recalcRate(rawParam);
 	}
+	void seedNoise(uint64_t seed)
+	{
+		rg.seed(seed);
+	}
 	void setUnsynced()
 	{
 		synced = false;
 		phaseInc = frUnsc;
 	}
-	void hostSyncRetrigger(float bpm,float quaters)
+	//Follows a BeatClock, the phase is only set from the beat when the clock jumped or the rate changed
+	//otherwise the lfo runs on at the tempo and is steered towards the beat
+	void hostSync(double beat,float beatsPerSecond,bool jumped)
 	{
 		if(synced)
 		{
-			phaseInc = (bpm/60.0)*syncRate;
-			phase = phaseInc*quaters;
-			phase = (fmod(phase,1)*float_Pi*2-float_Pi);
+			phaseInc = beatsPerSecond*syncRate;
+			double cycles = fmod(beat*syncRate,1);
+			if(cycles < 0)
+				cycles += 1;
+			if(jumped || beatPending)
+			{
+				phase = (cycles*float_Pi*2-float_Pi);
+				resyncCount = 0;
+				beatPending = false;
+			}
+			else
+			{
+				//float phase steps drift from the clock, the error is taken out over about a tenth of a second
+				double err = cycles - (phase+float_Pi)/(float_Pi*2);
+				err -= floor(err+0.5);
+				phaseInc += err*10;
+			}
 		}
 	}
 	inline float getVal()
@@ -90,17 +129,42 @@ public:
 		SampleRate=sr;
 		SampleRateInv = 1 / SampleRate;
 	}
-	inline void update()
+	//Advances n samples and writes getVal of each to out, out can be null to only advance
+	void processBlock(float* out,int n)
 	{
-		phase+=((phaseInc * float_Pi*2 * SampleRateInv));
-		sq = (phase>0?1:-1);
-		s = sin(phase);
-		if(phase > float_Pi)
+		const float inc = phaseInc * float_Pi*2 * SampleRateInv;
+		if(inc != rotInc)
 		{
-			phase-=2*float_Pi;
-			sh = rg.nextFloat()*2-1;
+			rotInc = inc;
+			rotC = cos((double)inc);
+			rotS = sin((double)inc);
+			resyncCount = 0;
+		}
+		for(int i = 0 ; i < n;i++)
+		{
+			phase+=inc;
+			if(--resyncCount <= 0)
+			{
+				qc = cos((double)phase);
+				qs = sin((double)phase);
+				resyncCount = RESYNC;
+			}
+			else
+			{
+				const double c = qc*rotC - qs*rotS;
+				qs = qs*rotC + qc*rotS;
+				qc = c;
+			}
+			sq = (phase>0?1:-1);
+			s = qs;
+			if(phase > float_Pi)
+			{
+				phase-=2*float_Pi;
+				sh = rg.next()*2;
+			}
+			if(out)
+				out[i] = getVal();
 		}
-
 	}
 	void setFrequency(float val)
 	{
@@ -154,6 +218,8 @@ public:
 			rt = 1;
 			break;
 		}
+		if(rt != syncRate)
+			beatPending = true;
 		syncRate = rt;
 	}
 };
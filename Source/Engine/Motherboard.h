@@ -23,23 +23,66 @@
 */
 #pragma once
 #include <climits>
+#include <memory>
+#include <new>
 #include "VoiceQueue.h"
 #include "SynthEngine.h"
 #include "Lfo.h"
+#include "FilterBank.h"
+#include "BitSet.h"
+#include "KeyHeap.h"
+#include "RenderPool.h"
 
 class Motherboard
 {
+public:
+	const static int MAX_BLOCK_SIZE = 64;
 private:
 	VoiceQueue vq;
 	int totalvc;
 	bool wasUni;
-	bool awaitingkeys[129];
 	int priorities[129];
 
-	Decimator17 left,right;
+	DecimatorChain decimator;
 	int asPlayedCounter;
 	float lkl,lkr;
 	float sampleRate,sampleRateInv;
+
+	//voice rate samples rendered at once, higher oversampling factors split the block
+	const static int VOICE_BLOCK_SIZE = MAX_BLOCK_SIZE*2;
+	//global lfo output at voice rate, the first LFO_DELAY samples are the end of the previous
+	//render so voices can read their delayed filter lfo from the same buffer
+	const static int LFO_DELAY = ObxdVoice::LFO_DELAY;
+	float lfoBuf[LFO_DELAY+VOICE_BLOCK_SIZE];
+	//per block scratch, voice rate when oversampling
+	float vibBuf[VOICE_BLOCK_SIZE];
+	float mixl[VOICE_BLOCK_SIZE];
+	float mixr[VOICE_BLOCK_SIZE];
+	//filter bank inputs of one voice group, interleaved by lane
+	//one set per render part so parts can run on different threads
+	struct BankScratch
+	{
+		float in[VOICE_BLOCK_SIZE*FilterBank::Lanes];
+		float cutIdx[VOICE_BLOCK_SIZE*FilterBank::Lanes];
+		float cutNoise[VOICE_BLOCK_SIZE*FilterBank::Lanes];
+		float env[VOICE_BLOCK_SIZE*FilterBank::Lanes];
+	};
+	BankScratch banks[RenderPool::MAX_PARTS];
+
+	//parallel rendering, voices of renderList are split into parts at partBegin
+	RenderPool pool;
+	int renderCount;
+	int partBegin[RenderPool::MAX_PARTS+1];
+	int renderSamples,renderOsShift;
+	const float* renderCutoffs;
+	const float* renderPitchWheels;
+	//log2 of the oversampling factor in use, the factor HQ turns on and the decimator tier
+	int osShift;
+	int hqFactor;
+	int decimatorType;
+	//below these a block is rendered on the audio thread alone
+	const static int MIN_PARALLEL_SAMPLES = 32;
+	const static int MIN_PARALLEL_VOICES = 2*FilterBank::Lanes;
 	//JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Motherboard)
 public:
 	bool asPlayedMode;
@@ -48,45 +91,247 @@ public:
 	bool vibratoEnabled;
 
 	float Volume;
-	const static int MAX_VOICES = 32;
+	//upper limit of the voice pool, the pool itself is sized by setVoicePoolSize
+	const static int MAX_VOICES = 128;
+	const static int DEFAULT_VOICES = 32;
     const static int MAX_PANNINGS = 8;
 	float pannings[MAX_PANNINGS];
-	ObxdVoice voices[MAX_VOICES];
+	ObxdVoice* voices;
+private:
+	//raw storage of the pool, new[] only honours the voice alignment from C++17 on
+	std::unique_ptr<char[]> voiceMemory;
+	int poolSize;
+	void freeVoicePool()
+	{
+		for(int i = 0 ; i < poolSize;i++)
+			voices[i].~ObxdVoice();
+		voiceMemory.reset();
+		voices = NULL;
+		poolSize = 0;
+	}
+	//voices whose envelope may be running, economy mode only renders these
+	//a clear bit means the voice is asleep with shouldProcessed false
+	BitSet<MAX_VOICES> awake;
+	inline void wake(ObxdVoice* p)
+	{
+		if(p->env.isActive())
+			awake.set((int)(p - voices));
+	}
+	//next voice index to render, skips sleeping voices in economy mode
+	inline int nextVoice(int from) const
+	{
+		return economyMode ? awake.findNext(from) : from;
+	}
+	//economy mode also puts releasing voices to sleep once their output stayed below
+	//cullLevel for CULL_HOLD_MS, 0 leaves them to their envelope
+	const static int CULL_HOLD_MS = 10;
+	float cullLevel;
+	//output samples each voice has been quiet for
+	int quietSamples[MAX_VOICES];
+	//after setVoiceLimit lowers the count the voices from totalvc up to rendervc are retiring,
+	//they are released, take no new notes and fade out over RETIRE_MS
+	//the rendered range shrinks once all of them are asleep
+	const static int RETIRE_MS = 30;
+	int rendervc;
+	//count asked for by setVoiceLimit, applied between chunks
+	int voiceLimit;
+	float retireGain[MAX_VOICES];
+	void updateVoiceLimit()
+	{
+		for(int k = totalvc ; k < rendervc;k++)
+			if(voices[k].env.isActive())
+				return;
+		rendervc = totalvc;
+		for(int k = voiceLimit ; k < totalvc;k++)
+		{
+			if(voices[k].Active)
+				voices[k].NoteOff();
+			retireGain[k] = 1;
+		}
+		rendervc = jmax(totalvc,voiceLimit);
+		totalvc = voiceLimit;
+		//allocation only tracks the voices below totalvc
+		vq.reInit(totalvc);
+		rebuildVoiceTracking();
+	}
+	//applies the next n samples of a retiring voice's fade, puts it to sleep at the end
+	void fadeRetiring(int k,float* out,int n)
+	{
+		const float step = 1000.0f/(RETIRE_MS*sampleRate*(1<<osShift));
+		float g = retireGain[k];
+		for(int i = 0 ; i < n;i++)
+		{
+			g = jmax(0.0f,g-step);
+			out[i] *= g;
+		}
+		retireGain[k] = g;
+		if(g == 0)
+			voices[k].sleep();
+	}
+
+	int renderList[MAX_VOICES];
+
+	//allocation bookkeeping, covers the voices below totalvc
+	//keys waiting for a free voice, the latest played on top of the heap
+	BitSet<129> awaiting;
+	KeyHeap<true> awaitingByPriority;
+	//mirrors ObxdVoice::Active
+	BitSet<MAX_VOICES> held;
+	//voices per midiIndx and the keys that have any, the earliest played on top of the heap
+	BitSet<MAX_VOICES> keyVoices[129];
+	BitSet<129> usedKeys;
+	KeyHeap<false> usedByPriority;
+	inline void setAwaiting(int key)
+	{
+		awaiting.set(key);
+		awaitingByPriority.insert(key);
+	}
+	inline void clearAwaiting(int key)
+	{
+		awaiting.clear(key);
+		awaitingByPriority.remove(key);
+	}
+	inline void setPriority(int key,int priority)
+	{
+		priorities[key] = priority;
+		awaitingByPriority.update(key);
+		usedByPriority.update(key);
+	}
+	inline void linkKey(int v,int key)
+	{
+		if(keyVoices[key].isEmpty())
+		{
+			usedKeys.set(key);
+			usedByPriority.insert(key);
+		}
+		keyVoices[key].set(v);
+	}
+	inline void unlinkKey(int v,int key)
+	{
+		keyVoices[key].clear(v);
+		if(keyVoices[key].isEmpty())
+		{
+			usedKeys.clear(key);
+			usedByPriority.remove(key);
+		}
+	}
+	inline void voiceOn(ObxdVoice* p,int noteNo,float velocity)
+	{
+		const int v = (int)(p - voices);
+		if(p->midiIndx != noteNo)
+		{
+			unlinkKey(v,p->midiIndx);
+			linkKey(v,noteNo);
+		}
+		p->NoteOn(noteNo,velocity);
+		held.set(v);
+		wake(p);
+	}
+	inline void voiceOff(ObxdVoice* p)
+	{
+		p->NoteOff();
+		held.clear((int)(p - voices));
+		wake(p);
+	}
+	void rebuildVoiceTracking()
+	{
+		held.clearAll();
+		usedKeys.clearAll();
+		usedByPriority.clear();
+		for(int k = 0 ; k < 129;k++)
+			keyVoices[k].clearAll();
+		for(int i = 0 ; i < totalvc;i++)
+		{
+			if(voices[i].Active)
+				held.set(i);
+			linkKey(i,voices[i].midiIndx);
+		}
+	}
+	//first voice of the set in the order VoiceQueue would hand them out, MAX_VOICES when empty
+	inline int firstInQueueOrder(const BitSet<MAX_VOICES>& set) const
+	{
+		int start = vq.getIndex()+1;
+		if(start >= totalvc)
+			start = 0;
+		const int v = set.findNext(start);
+		return v < MAX_VOICES ? v : set.findNext(0);
+	}
+	//same for voices that are not held
+	inline int firstFreeInQueueOrder() const
+	{
+		int start = vq.getIndex()+1;
+		if(start >= totalvc)
+			start = 0;
+		const int v = held.findNextClear(start);
+		return v < totalvc ? v : held.findNextClear(0);
+	}
+public:
+
+	//smoothed controls for the next processBlock, one value per output sample
+	float cutoffs[MAX_BLOCK_SIZE];
+	float pitchWheels[MAX_BLOCK_SIZE];
+	float vibratoAmounts[MAX_BLOCK_SIZE];
+	//per voice output of the last processBlock
+	float voiceOut[MAX_VOICES][VOICE_BLOCK_SIZE];
 	bool uni;
 	bool Oversample;
 
 	bool economyMode;
-	Motherboard(): left(),right()
+	//economy mode counters, voice samples at the output rate
+	struct CullStats
+	{
+		int64 renderedSamples;
+		int64 culledVoices;
+		//release samples the culled voices had left, taken from their envelopes
+		int64 savedSamples;
+	};
+	CullStats cullStats;
+	Motherboard(): priorities(),
+		decimator(),
+		awaitingByPriority(priorities),
+		usedByPriority(priorities)
 	{
 		economyMode = true;
 		lkl=lkr=0;
 		vibratoEnabled = true;
 		asPlayedMode = false;
 		asPlayedCounter = 0;
-		for(int i = 0 ; i < 129 ; i++)
-		{
-			awaitingkeys[i] = false;
-			priorities[i] = 0;
-		}
 		vibratoAmount = 0;
 		Oversample=false;
+		osShift = 0;
+		hqFactor = 2;
+		decimatorType = DECIMATOR_FIR;
 		mlfo= Lfo();
 		vibratoLfo=Lfo();
 		vibratoLfo.waveForm = 1;
 		uni = false;
 		wasUni = false;
 		Volume=0;
-	//	voices = new ObxdVoice* [MAX_VOICES];
-	//	pannings = new float[MAX_VOICES];
-		totalvc = MAX_VOICES;
-		vq = VoiceQueue(MAX_VOICES,voices);
+		sampleRate = 44100;
+		sampleRateInv = 1 / sampleRate;
+		poolSize = 0;
+		totalvc = rendervc = voiceLimit = 0;
+		voices = NULL;
+		setVoicePoolSize(DEFAULT_VOICES);
 		for(int i = 0 ; i < MAX_PANNINGS;++i)
 		{
 			pannings[i]= 0.5;
 		}
+		//unused lanes of a partial group read these
+		zeromem(banks,sizeof(banks));
+		zeromem(lfoBuf,sizeof(lfoBuf));
+		cullLevel = 0;
+		zeromem(quietSamples,sizeof(quietSamples));
+		zeromem(retireGain,sizeof(retireGain));
+		resetCullStats();
+		renderCount = 0;
+		renderSamples = renderOsShift = 0;
+		renderCutoffs = cutoffs;
+		renderPitchWheels = pitchWheels;
 	}
 	~Motherboard()
 	{
+		freeVoicePool();
 		//delete pannings;
 		//for(int i = 0 ; i < MAX_VOICES;++i)
 		//{
@@ -94,28 +339,96 @@ public:
 		//}
 		//delete voices;
 	}
+	//allocates a fresh pool of count voices, not for the audio thread
+	//voice parameters have to be set again afterwards
+	void setVoicePoolSize(int count)
+	{
+		count = jlimit(1,(int)MAX_VOICES,count);
+		if(count == poolSize)
+			return;
+		freeVoicePool();
+		const size_t align = alignof(ObxdVoice);
+		voiceMemory.reset(new char[count*sizeof(ObxdVoice)+align]);
+		const uintptr_t base = (uintptr_t)voiceMemory.get();
+		voices = (ObxdVoice*)((base + align-1) & ~(uintptr_t)(align-1));
+		for(int i = 0 ; i < count;i++)
+			new (voices+i) ObxdVoice();
+		poolSize = count;
+		awake.clearAll();
+		totalvc = jmin(totalvc,count);
+		if(totalvc <= 0)
+			totalvc = count;
+		rendervc = voiceLimit = totalvc;
+		vq = VoiceQueue(totalvc,voices);
+		rebuildVoiceTracking();
+		setSampleRate(sampleRate);
+	}
+	int getVoicePoolSize() const
+	{
+		return poolSize;
+	}
 	void setVoiceCount(int count)
 	{
-		for(int i = count ; i < MAX_VOICES;i++)
+		for(int i = count ; i < poolSize;i++)
 		{
 			voices[i].NoteOff();
 			voices[i].ResetEnvelope();
 		}
 		vq.reInit(count);
-		totalvc = count;
+		totalvc = rendervc = voiceLimit = count;
+		rebuildVoiceTracking();
+	}
+	//like setVoiceCount for new notes, voices above count are released and faded out
+	//instead of being cut off, safe on the audio thread
+	void setVoiceLimit(int count)
+	{
+		voiceLimit = jlimit(1,poolSize,count);
 	}
 	void unisonOn()
 	{
 		//for(int i = 0 ; i < 110;i++)
 		//	awaitingkeys[i] = false;
 	}
+	//0 renders on the audio thread only, not for the audio thread
+	void setRenderThreads(int count)
+	{
+		pool.setNumWorkers(count);
+	}
+	//around every host block, render workers spin in between and sleep outside
+	void beginBlock()
+	{
+		pool.beginBlock();
+	}
+	void endBlock()
+	{
+		pool.endBlock();
+	}
+	//level in dB relative to full scale at the current Volume, 0 or above turns culling off
+	void setCullLevel(float db)
+	{
+		cullLevel = db < 0 ? pow(10.0f,db/20) : 0;
+	}
+	void resetCullStats()
+	{
+		cullStats.renderedSamples = 0;
+		cullStats.culledVoices = 0;
+		cullStats.savedSamples = 0;
+	}
+	//makes every noise stream repeat from here on, seeds are taken from seed upwards
+	void seedNoise(uint64_t seed)
+	{
+		mlfo.seedNoise(seed);
+		vibratoLfo.seedNoise(seed+1);
+		for(int i = 0 ; i < poolSize;i++)
+			voices[i].seedNoise(seed+2+2*i);
+	}
 	void setSampleRate(float sr)
 	{
 		sampleRate = sr;
 		sampleRateInv = 1 / sampleRate;
 		mlfo.setSamlpeRate(sr);
 		vibratoLfo.setSamlpeRate(sr);
-		for(int i = 0 ; i < MAX_VOICES;++i)
+		for(int i = 0 ; i < poolSize;++i)
 		{
 			voices[i].setSampleRate(sr);
 		}
@@ -123,7 +436,7 @@ public:
 	}
 	void sustainOn()
 	{
-		for(int i = 0 ; i < MAX_VOICES;i++)
+		for(int i = 0 ; i < poolSize;i++)
 		{
 			ObxdVoice* p = vq.getNext();
 			p->sustOn();
@@ -131,16 +444,17 @@ public:
 	}
 	void sustainOff()
 	{
-		for(int i = 0 ; i < MAX_VOICES;i++)
+		for(int i = 0 ; i < poolSize;i++)
 		{
 			ObxdVoice* p = vq.getNext();
 			p->sustOff();
+			wake(p);
 		}
 	}
 	void setNoteOn(int noteNo,float velocity)
 	{
 		asPlayedCounter++;
-		priorities[noteNo] = asPlayedCounter;
+		setPriority(noteNo,asPlayedCounter);
 		bool processed=false;
 		if (wasUni != uni)
 			unisonOn();
@@ -148,18 +462,19 @@ public:
 		{
 			if(!asPlayedMode)
 			{
+				//lowest key of an active voice
 				int minmidi = 129;
-				for(int i = 0 ; i < totalvc; i++)
+				for(int k = usedKeys.findFirst() ; k < 129;k = usedKeys.findNext(k+1))
 				{
-					ObxdVoice* p = vq.getNext();
-					if(p->midiIndx < minmidi && p->Active)
+					if(!(keyVoices[k] & held).isEmpty())
 					{
-						minmidi = p->midiIndx;
+						minmidi = k;
+						break;
 					}
 				}
 				if(minmidi < noteNo)
 				{
-					awaitingkeys[noteNo] = true;
+					setAwaiting(noteNo);
 				}
 				else
 				{
@@ -168,12 +483,12 @@ public:
 						ObxdVoice* p = vq.getNext();
 						if(p->midiIndx > noteNo && p->Active)
 						{
-							awaitingkeys[p->midiIndx] = true;
-							p->NoteOn(noteNo,-0.5);
+							setAwaiting(p->midiIndx);
+							voiceOn(p,noteNo,-0.5);
 						}
 						else
 						{
-							p->NoteOn(noteNo,velocity);
+							voiceOn(p,noteNo,velocity);
 						}
 					}
 				}
@@ -186,12 +501,12 @@ public:
 					ObxdVoice* p = vq.getNext();
 					if(p->Active)
 					{
-						awaitingkeys[p->midiIndx] = true;
-											p->NoteOn(noteNo,-0.5);
+						setAwaiting(p->midiIndx);
+						voiceOn(p,noteNo,-0.5);
 					}
 					else
 					{
-					p->NoteOn(noteNo,velocity);
+						voiceOn(p,noteNo,velocity);
 					}
 				}
 				processed = true;
@@ -199,58 +514,43 @@ public:
 		}
 		else
 		{
-			for (int i = 0; i < totalvc && !processed; i++)
+			const int v = firstFreeInQueueOrder();
+			if(v < totalvc)
 			{
-				ObxdVoice* p = vq.getNext();
-				if (!p->Active)
-				{
-					p->NoteOn(noteNo,velocity);
-					processed = true;
-				}
+				voiceOn(vq.getAt(v),noteNo,velocity);
+				processed = true;
 			}
 		}
 		// if voice steal occured
 		if(!processed)
 		{
-			//
+			//every voice is held here
 			if(!asPlayedMode)
 			{
 				int maxmidi = 0;
 				ObxdVoice* highestVoiceAvalible = NULL;
-				for(int i = 0 ; i < totalvc; i++)
+				const int top = usedKeys.findLast();
+				//key 0 counts too, a null voice would be used below otherwise
+				if(top >= 0)
 				{
-					ObxdVoice* p = vq.getNext();
-					if(p->midiIndx > maxmidi)
-					{
-						maxmidi = p->midiIndx;
-						highestVoiceAvalible = p;
-					}
+					maxmidi = top;
+					highestVoiceAvalible = &voices[firstInQueueOrder(keyVoices[top])];
 				}
 				if(maxmidi < noteNo)
 				{
-					awaitingkeys[noteNo] = true;
+					setAwaiting(noteNo);
 				}
 				else
 				{
-					highestVoiceAvalible->NoteOn(noteNo,-0.5);
-					awaitingkeys[maxmidi] = true;
+					voiceOn(highestVoiceAvalible,noteNo,-0.5);
+					setAwaiting(maxmidi);
 				}
 			}
 			else
 			{
-				int minPriority = INT_MAX;
-				ObxdVoice* minPriorityVoice = NULL;
-				for(int i = 0 ; i < totalvc; i++)
-				{
-					ObxdVoice* p = vq.getNext();
-					if(priorities[p->midiIndx] <minPriority)
-					{
-						minPriority = priorities[p->midiIndx];
-						minPriorityVoice = p;
-					}
-				}
-				awaitingkeys[minPriorityVoice->midiIndx] = true;
-				minPriorityVoice->NoteOn(noteNo,-0.5);
+				ObxdVoice* minPriorityVoice = &voices[firstInQueueOrder(keyVoices[usedByPriority.top()])];
+				setAwaiting(minPriorityVoice->midiIndx);
+				voiceOn(minPriorityVoice,noteNo,-0.5);
 			}
 		}
 		wasUni = uni;
@@ -258,84 +558,58 @@ public:
 
 	void setNoteOff(int noteNo)
 	{
-		awaitingkeys[noteNo] = false;
-		int reallocKey = 0;
+		clearAwaiting(noteNo);
 		//Voice release case
-		if(!asPlayedMode)
-		{
-			while(reallocKey < 129 &&(!awaitingkeys[reallocKey]))
-			{
-				reallocKey++;
-			}
-		}
-		else
-		{
-			reallocKey = 129;
-			int maxPriority = INT_MIN;
-			for(int i = 0 ; i < 129;i++)
-			{
-				if(awaitingkeys[i] && (maxPriority < priorities[i]))
-				{
-					reallocKey = i;
-					maxPriority = priorities[i];
-				}
-			}
-		}
+		const int reallocKey = asPlayedMode ? awaitingByPriority.top() : awaiting.findFirst();
+		const BitSet<MAX_VOICES> playing = keyVoices[noteNo] & held;
 		if(reallocKey !=129)
 		{
-			for(int i = 0 ; i < totalvc; i++)
+			for(int v = playing.findFirst() ; v < MAX_VOICES;v = playing.findNext(v+1))
 			{
-				ObxdVoice* p = vq.getNext();
-				if((p->midiIndx == noteNo) && (p->Active))
-				{
-					p->NoteOn(reallocKey,-0.5);
-					awaitingkeys[reallocKey] = false;
-				}
-
+				voiceOn(&voices[v],reallocKey,-0.5);
+				clearAwaiting(reallocKey);
 			}
 		}
 		else
 		//No realloc
 		{
-			for (int i = 0; i < totalvc; i++)
+			for(int v = playing.findFirst() ; v < MAX_VOICES;v = playing.findNext(v+1))
 			{
-				ObxdVoice* n = vq.getNext();
-				if (n->midiIndx==noteNo && n->Active)
-				{
-					n->NoteOff();
-				}
+				voiceOff(&voices[v]);
 			}
 		}
 	}
+	//factor used while oversampling is on, 2, 4 or 8, and one of the DECIMATOR_ types
+	void setOversampleFactor(int factor,int decimator)
+	{
+		hqFactor = factor >= 8 ? 8 : factor >= 4 ? 4 : 2;
+		decimatorType = jlimit((int)DECIMATOR_FIR,(int)DECIMATOR_IIR,decimator);
+		SetOversample(Oversample);
+	}
 	void SetOversample(bool over)
 	{
-		if(over==true)
-		{
-			mlfo.setSamlpeRate(sampleRate*2);
-			vibratoLfo.setSamlpeRate(sampleRate*2);
-		}
-		else
-		{
-			mlfo.setSamlpeRate(sampleRate);
-			vibratoLfo.setSamlpeRate(sampleRate);
-		}
-		for(int i = 0 ; i < MAX_VOICES;i++)
+		const int factor = over ? hqFactor : 1;
+		osShift = 0;
+		while((2<<osShift) <= factor)
+			osShift++;
+		mlfo.setSamlpeRate(sampleRate*factor);
+		vibratoLfo.setSamlpeRate(sampleRate*factor);
+		for(int i = 0 ; i < poolSize;i++)
 		{
 			voices[i].setHQ(over);
-			if(over)
-				voices[i].setSampleRate(sampleRate*2);
-			else
-				voices[i].setSampleRate(sampleRate);
+			voices[i].setSampleRate(sampleRate*factor);
 		}
+		decimator.setFactor(factor,decimatorType);
 		Oversample = over;
 	}
-	inline float processSynthVoice(ObxdVoice& b,float lfoIn,float vibIn )
+	inline float processSynthVoice(ObxdVoice& b,float lfoIn,float lfoDelayedIn,float vibIn )
 	{
 		if(economyMode)
 			b.checkAdsrState();
 		if(b.shouldProcessed||(!economyMode))
 		{
 				b.lfoIn=lfoIn;
+				b.lfoDelayedIn=lfoDelayedIn;
 				b.lfoVibratoIn=vibIn;
 				return b.ProcessSample();
 		}
@@ -343,39 +617,212 @@ public:
 	}
 	void processSample(float* sm1,float* sm2)
 	{
-		mlfo.update();
-		vibratoLfo.update();
-		float vl=0,vr=0;
-		float vlo = 0 , vro = 0 ;
-		float lfovalue = mlfo.getVal();
-		float viblfo = vibratoEnabled?(vibratoLfo.getVal() * vibratoAmount):0;
-		float lfovalue2=0,viblfo2;
-		if(Oversample)
-		{		
-			mlfo.update();
-		vibratoLfo.update();
-		lfovalue2 = mlfo.getVal();
-		viblfo2 = vibratoEnabled?(vibratoLfo.getVal() * vibratoAmount):0;
+		const int n = 1<<osShift;
+		float viblfo[DecimatorChain::MAX_FACTOR];
+		float vl[DecimatorChain::MAX_FACTOR],vr[DecimatorChain::MAX_FACTOR];
+		const float* lfovalue = renderLfo(viblfo,n);
+		for(int j = 0 ; j < n;j++)
+		{
+			viblfo[j] *= vibratoAmount;
+			vl[j] = vr[j] = 0;
 		}
 
-		for(int i = 0 ; i < totalvc;i++)
+		if(voiceLimit != totalvc || rendervc != totalvc)
+			updateVoiceLimit();
+		for(int i = nextVoice(0) ; i < rendervc;i = nextVoice(i+1))
 		{
-				float x1 = processSynthVoice(voices[i],lfovalue,viblfo);
-				if(Oversample)
+				for(int j = 0 ; j < n;j++)
 				{
-					float x2 =  processSynthVoice(voices[i],lfovalue2,viblfo2);
-					vlo+=x2*(1-pannings[i % MAX_PANNINGS]);
-					vro+=x2*(pannings[i % MAX_PANNINGS]);
+					float x = processSynthVoice(voices[i],lfovalue[j],lfovalue[j-LFO_DELAY],viblfo[j]);
+					if(i >= totalvc)
+						fadeRetiring(i,&x,1);
+					vl[j]+=x*(1-pannings[i % MAX_PANNINGS]);
+					vr[j]+=x*(pannings[i % MAX_PANNINGS]);
 				}
-				vl+=x1*(1-pannings[i % MAX_PANNINGS]);
-				vr+=x1*(pannings[i % MAX_PANNINGS]);
+				if(economyMode && !voices[i].shouldProcessed)
+					awake.clear(i);
 		}
-		if(Oversample)
+		shiftLfo(n);
+		decimator.process(vl,vr,1);
+		*sm1 = vl[0]*Volume;
+		*sm2 = vr[0]*Volume;
+	}
+	//renders numSamples <= MAX_BLOCK_SIZE samples
+	//cutoffs, pitchWheels and vibratoAmounts should be filled before the call
+	void processBlock(float* sm1,float* sm2,int numSamples)
+	{
+		const int chunk = VOICE_BLOCK_SIZE>>osShift;
+		for(int start = 0 ; start < numSamples;start += chunk)
+			processChunk(sm1+start,sm2+start,start,jmin(chunk,numSamples-start));
+	}
+private:
+	//renders output samples start to start+numSamples of the block, at most VOICE_BLOCK_SIZE voice samples
+	void processChunk(float* sm1,float* sm2,int start,int numSamples)
+	{
+		const int vn = numSamples<<osShift;
+		renderLfo(vibBuf,vn);
+		for(int i = 0 ; i < vn;i++)
 		{
-			vl = left.Calc(vl,vlo);
-			vr = right.Calc(vr,vro);
+			vibBuf[i] *= vibratoAmounts[start+(i>>osShift)];
+			mixl[i] = mixr[i] = 0;
+		}
+		if(voiceLimit != totalvc || rendervc != totalvc)
+			updateVoiceLimit();
+		renderCount = 0;
+		for(int k = nextVoice(0) ; k < rendervc;k = nextVoice(k+1))
+		{
+			if(economyMode && !voices[k].env.isActive())
+			{
+				//sleeping for the whole block, nothing to mix
+				voices[k].shouldProcessed = false;
+				awake.clear(k);
+				continue;
+			}
+			renderList[renderCount++] = k;
+		}
+		//parts hold whole filter bank groups, every voice renders into its own buffer
+		//so the split does not change the result
+		const int L = FilterBank::Lanes;
+		int parts = 1;
+		if(pool.getNumWorkers() > 0 && vn >= MIN_PARALLEL_SAMPLES && renderCount >= MIN_PARALLEL_VOICES)
+			parts = jmin(pool.getNumWorkers()+1,(renderCount+L-1)/L);
+		const int groups = (renderCount+L-1)/L;
+		for(int p = 0 ; p <= parts;p++)
+			partBegin[p] = jmin(renderCount,(groups*p/parts)*L);
+		renderSamples = vn;
+		renderOsShift = osShift;
+		renderCutoffs = cutoffs+start;
+		renderPitchWheels = pitchWheels+start;
+		if(parts > 1)
+			pool.run(renderPartCallback,this,parts);
+		else
+			renderPart(0);
+		if(economyMode)
+		{
+			cullStats.renderedSamples += (int64)renderCount*numSamples;
+			if(cullLevel > 0)
+				cullQuietVoices(numSamples);
+		}
+		for(int r = renderCount-1 ; r >= 0 && renderList[r] >= totalvc;r--)
+			fadeRetiring(renderList[r],voiceOut[renderList[r]],vn);
+		for(int r = 0 ; r < renderCount;r++)
+		{
+			const int k = renderList[r];
+			if(economyMode && !voices[k].shouldProcessed)
+				awake.clear(k);
+		}
+		//mixing in voice order keeps the sums identical to processSample
+		for(int r = 0 ; r < renderCount;r++)
+		{
+			const int k = renderList[r];
+			const float pan = pannings[k % MAX_PANNINGS];
+			for(int i = 0 ; i < vn;i++)
+			{
+				mixl[i]+=voiceOut[k][i]*(1-pan);
+				mixr[i]+=voiceOut[k][i]*pan;
+			}
+		}
+		shiftLfo(vn);
+		decimator.process(mixl,mixr,numSamples);
+		for(int i = 0 ; i < numSamples;i++)
+		{
+			sm1[i] = mixl[i]*Volume;
+			sm2[i] = mixr[i]*Volume;
+		}
+	}
+	//renders n voice rate samples of both global lfos, the vibrato lfo unscaled into vib
+	//returns where the main lfo samples start, the LFO_DELAY samples before them are history
+	const float* renderLfo(float* vib,int n)
+	{
+		float* lfo = lfoBuf+LFO_DELAY;
+		mlfo.processBlock(lfo,n);
+		if(vibratoEnabled)
+			vibratoLfo.processBlock(vib,n);
+		else
+		{
+			vibratoLfo.processBlock(NULL,n);
+			for(int i = 0 ; i < n;i++)
+				vib[i] = 0;
+		}
+		return lfo;
+	}
+	//keeps the last LFO_DELAY samples of a render as history for the next one
+	void shiftLfo(int n)
+	{
+		memmove(lfoBuf,lfoBuf+n,LFO_DELAY*sizeof(float));
+	}
+	//releasing voices that stayed below cullLevel are faded out over this chunk and put to sleep
+	void cullQuietVoices(int numSamples)
+	{
+		const int vn = numSamples<<osShift;
+		const float limit = cullLevel*cullLevel*vn;
+		const int hold = (int)(sampleRate*CULL_HOLD_MS/1000);
+		for(int r = 0 ; r < renderCount;r++)
+		{
+			const int k = renderList[r];
+			ObxdVoice& b = voices[k];
+			if(!b.shouldProcessed || !b.env.isReleasing())
+			{
+				quietSamples[k] = 0;
+				continue;
+			}
+			float sum = 0;
+			for(int i = 0 ; i < vn;i++)
+				sum += voiceOut[k][i]*voiceOut[k][i];
+			if(sum*Volume*Volume >= limit)
+			{
+				quietSamples[k] = 0;
+				continue;
+			}
+			quietSamples[k] += numSamples;
+			if(quietSamples[k] < hold)
+				continue;
+			const float step = 1.0f/vn;
+			for(int i = 0 ; i < vn;i++)
+				voiceOut[k][i] *= 1 - (i+1)*step;
+			cullStats.culledVoices++;
+			cullStats.savedSamples += b.env.releaseRemaining()>>osShift;
+			quietSamples[k] = 0;
+			b.sleep();
+		}
+	}
+	static void renderPartCallback(void* context,int part)
+	{
+		((Motherboard*)context)->renderPart(part);
+	}
+	//voices are rendered in two stages, oscillators and modulation per voice
+	//then cutoff, filter and amp for groups of FilterBank::Lanes voices
+	void renderPart(int part)
+	{
+		const int L = FilterBank::Lanes;
+		const int vn = renderSamples;
+		BankScratch& bank = banks[part];
+		ObxdVoice* group[FilterBank::Lanes];
+		float* groupOut[FilterBank::Lanes];
+		int lanes = 0;
+		for(int r = partBegin[part] ; r < partBegin[part+1];r++)
+		{
+			const int k = renderList[r];
+			ObxdVoice& b = voices[k];
+			int processed = b.processBlockPreFilter(bank.in+lanes,bank.cutIdx+lanes,bank.cutNoise+lanes,bank.env+lanes,L,
+				vn,lfoBuf+LFO_DELAY,vibBuf,renderCutoffs,renderPitchWheels,renderOsShift,economyMode);
+			if(processed < vn)
+			{
+				//went to sleep inside the block, filter state must stop where the voice did
+				b.processBlockFilter(voiceOut[k],bank.in+lanes,bank.cutIdx+lanes,bank.cutNoise+lanes,bank.env+lanes,L,processed);
+				for(int i = processed ; i < vn;i++)
+					voiceOut[k][i] = 0;
+				continue;
+			}
+			group[lanes] = &b;
+			groupOut[lanes] = voiceOut[k];
+			if(++lanes == L)
+			{
+				FilterBank::process(group,lanes,bank.in,bank.cutIdx,bank.cutNoise,bank.env,groupOut,vn);
+				lanes = 0;
+			}
 		}
-		*sm1 = vl*Volume;
-		*sm2 = vr*Volume;
+		if(lanes > 0)
+			FilterBank::process(group,lanes,bank.in,bank.cutIdx,bank.cutNoise,bank.env,groupOut,vn);
 	}
 };
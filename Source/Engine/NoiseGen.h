@@ -0,0 +1,83 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+//Uniform white noise in [-0.5,0.5), the range of Random::nextFloat()-0.5
+//Several xorshift32 streams step side by side and fill a small buffer at once,
+//the loop over the streams vectorizes, next() only reads the buffer
+class NoiseGen
+{
+	const static int STREAMS = 8;
+	const static int BUFFER = 4*STREAMS;
+	uint32_t state[STREAMS];
+	float buf[BUFFER];
+	int pos;
+	void refill()
+	{
+		for(int i = 0 ; i < BUFFER;i+=STREAMS)
+		{
+			for(int s = 0 ; s < STREAMS;s++)
+			{
+				uint32_t x = state[s];
+				x ^= x << 13;
+				x ^= x >> 17;
+				x ^= x << 5;
+				state[s] = x;
+				//top 23 bits as the mantissa of a float in [1,2)
+				const uint32_t bits = (x >> 9) | 0x3f800000u;
+				float f;
+				memcpy(&f,&bits,sizeof(f));
+				buf[i+s] = f - 1.5f;
+			}
+		}
+		pos = 0;
+	}
+public:
+	NoiseGen()
+	{
+		seed(1);
+	}
+	//streams of the same seed are identical, different seeds give unrelated streams
+	void seed(uint64_t s)
+	{
+		for(int i = 0 ; i < STREAMS;i++)
+		{
+			//splitmix64 spreads the seed over the stream states
+			s += 0x9e3779b97f4a7c15ull;
+			uint64_t z = s;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			z ^= z >> 31;
+			state[i] = (uint32_t)z | 1;
+		}
+		pos = BUFFER;
+	}
+	inline float next()
+	{
+		if(pos == BUFFER)
+			refill();
+		return buf[pos++];
+	}
+};
@@ -31,6 +31,8 @@
 #include "SawOsc.h"
 #include "PulseOsc.h"
 #include "TriangleOsc.h"
+#include "NoiseGen.h"
+#include <type_traits>
 
 class ObxdOscillatorB
 {
@@ -56,7 +58,31 @@ private:
 	DelayLineBoolean<Samples> syncd;
 	DelayLine<Samples> syncFracd;
 	DelayLine<Samples> cvd;
-	Random wn;
+	NoiseGen wn;
+
+	//waveform and sync switches, set through the setters so the kernel follows them
+	bool osc1Saw,osc2Saw,
+		osc1Pul,osc2Pul;
+	bool hardSync;
+	bool quantizeCw;
+	typedef float (ObxdOscillatorB::*Kernel)();
+	Kernel kernel;
+	//turns the switches into template arguments one at a time
+	template<bool... Chosen> Kernel pickKernel(const bool*,std::integral_constant<int,6>)
+	{
+		return &ObxdOscillatorB::processSampleKernel<Chosen...>;
+	}
+	template<bool... Chosen,int N> Kernel pickKernel(const bool* flags,std::integral_constant<int,N>)
+	{
+		if(flags[N])
+			return pickKernel<Chosen...,true>(flags,std::integral_constant<int,N+1>());
+		return pickKernel<Chosen...,false>(flags,std::integral_constant<int,N+1>());
+	}
+	void updateKernel()
+	{
+		const bool flags[6] = { osc1Saw,osc1Pul,osc2Saw,osc2Pul,hardSync,quantizeCw };
+		kernel = pickKernel<>(flags,std::integral_constant<int,0>());
+	}
 	SawOsc o1s,o2s;
 	PulseOsc o1p,o2p;
 	TriangleOsc o1t,o2t;
@@ -77,21 +103,17 @@ public:
 	float pw1,pw2;
 
 
-	bool quantizeCw;
-
 	float o1mx,o2mx;
 	float nmx;
 	float pto1,pto2;
 
 
-	//osc pitches
-	float osc1Saw,osc2Saw,
-		osc1Pul,osc2Pul;
-
 	float osc1p,osc2p;
-	bool hardSync;
 	float xmod;
 
+	//one of the PITCH_ tiers from AudioUtils.h
+	int pitchPrecision;
+
 
 	ObxdOscillatorB() : 
 		n(Samples*2),
@@ -102,9 +124,9 @@ public:
 	{
 		dirt = 0.1;
 		totalDetune = 0;
-		wn = Random(Random::getSystemRandom().nextInt64());
-		osc1Factor = wn.nextFloat()-0.5;
-		osc2Factor = wn.nextFloat()-0.5;
+		wn.seed(Random::getSystemRandom().nextInt64());
+		osc1Factor = wn.next();
+		osc2Factor = wn.next();
 		nmx=0;
 		oct=0;
 		tune=0;
@@ -113,14 +135,17 @@ public:
 		pw1=pw2=0;
 		xmod = 0;
 		hardSync = false;
+		quantizeCw = false;
+		pitchPrecision = PITCH_EXACT;
 		osc1p=osc2p=10;
 		osc1Saw=osc2Saw=osc1Pul=osc2Pul=false;
 		osc2Det = 0;
 		notePlaying = 30;
 		pulseWidth = 0;
 		o1mx=o2mx=0;
-		x1=wn.nextFloat();
-		x2=wn.nextFloat();
+		x1=wn.next()+0.5f;
+		x2=wn.next()+0.5f;
+		updateKernel();
 
 		//del1 = new DelayLine(hsam);
 		//del2 = new DelayLine(hsam);
@@ -138,6 +163,11 @@ public:
 		//delete syncd;
 		//delete syncFracd;
 	}
+	//restarts the pitch noise stream, the same seed repeats the same noise
+	void seedNoise(uint64_t seed)
+	{
+		wn.seed(seed);
+	}
 	void setDecimation()
 	{
 		o1p.setDecimation();
@@ -161,10 +191,22 @@ public:
 		SampleRate = sr;
 		sampleRateInv = 1.0f / SampleRate;
 	}
+	void setOsc1Saw(bool on) { osc1Saw = on; updateKernel(); }
+	void setOsc1Pulse(bool on) { osc1Pul = on; updateKernel(); }
+	void setOsc2Saw(bool on) { osc2Saw = on; updateKernel(); }
+	void setOsc2Pulse(bool on) { osc2Pul = on; updateKernel(); }
+	void setHardSync(bool on) { hardSync = on; updateKernel(); }
+	void setQuantize(bool on) { quantizeCw = on; updateKernel(); }
 	inline float ProcessSample()
 	{
-		float noiseGen = wn.nextFloat()-0.5;
-		pitch1 = getPitch(dirt * noiseGen + notePlaying + (quantizeCw?((int)(osc1p)):osc1p)+ pto1 + tune + oct+totalDetune*osc1Factor);
+		return (this->*kernel)();
+	}
+	//Oscillator core specialized on the waveform and sync switches so the sample loop has no mode branches
+	//updateKernel picks the instance whenever a switch changes
+	template<bool Osc1Saw,bool Osc1Pul,bool Osc2Saw,bool Osc2Pul,bool HardSync,bool QuantizeCw> float processSampleKernel()
+	{
+		float noiseGen = wn.next();
+		pitch1 = getPitch(dirt * noiseGen + notePlaying + (QuantizeCw?((int)(osc1p)):osc1p)+ pto1 + tune + oct+totalDetune*osc1Factor,pitchPrecision);
 		bool hsr = false;
 		float hsfrac=0;
 		float fs = jmin(pitch1*(sampleRateInv),0.45f);
@@ -173,11 +215,11 @@ public:
 		float osc1mix=0.0f;
 		float pwcalc =jlimit<float>(0.1f,1.0f,(pulseWidth + pw1)*0.5f + 0.5f);
 
-		if(osc1Pul)
+		if(Osc1Pul)
 			o1p.processMaster(x1,fs,pwcalc,pw1w);
-		if(osc1Saw)
+		if(Osc1Saw)
 			o1s.processMaster(x1,fs);
-		else if(!osc1Pul)
+		else if(!Osc1Pul)
 			o1t.processMaster(x1,fs);
 
 		if(x1 >= 1.0f)
@@ -191,22 +233,22 @@ public:
 
 		pw1w = pwcalc;
 
-		hsr &= hardSync;
+		hsr &= HardSync;
 		//Delaying our hard sync gate signal and frac
 		hsr = syncd.feedReturn(hsr) != 0.0f;
 		hsfrac = syncFracd.feedReturn(hsfrac);
 
-		if(osc1Pul)
+		if(Osc1Pul)
 			osc1mix += o1p.getValue(x1,pwcalc) + o1p.aliasReduction();
-		if(osc1Saw)
+		if(Osc1Saw)
 			osc1mix += o1s.getValue(x1) + o1s.aliasReduction();
-		else if(!osc1Pul)
+		else if(!Osc1Pul)
 			osc1mix = o1t.getValue(x1) + o1t.aliasReduction();
 		//Pitch control needs additional delay buffer to compensate
 		//This will give us less aliasing on xmod
 		//Hard sync gate signal delayed too
-		noiseGen = wn.nextFloat()-0.5;
-		pitch2 = getPitch(cvd.feedReturn(dirt *noiseGen + notePlaying + osc2Det + (quantizeCw?((int)(osc2p)):osc2p) + pto2+ osc1mix *xmod + tune + oct +totalDetune*osc2Factor));
+		noiseGen = wn.next();
+		pitch2 = getPitch(cvd.feedReturn(dirt *noiseGen + notePlaying + osc2Det + (QuantizeCw?((int)(osc2p)):osc2p) + pto2+ osc1mix *xmod + tune + oct +totalDetune*osc2Factor),pitchPrecision);
 
 		fs = jmin(pitch2 * (sampleRateInv),0.45f);
 
@@ -216,11 +258,11 @@ public:
 
 		x2 +=fs;
 
-		if(osc2Pul)
+		if(Osc2Pul)
 			o2p.processSlave(x2,fs,hsr,hsfrac,pwcalc,pw2w);
-		if(osc2Saw)
+		if(Osc2Saw)
 			o2s.processSlave(x2,fs,hsr,hsfrac);
-		else if(!osc2Pul)
+		else if(!Osc2Pul)
 			o2t.processSlave(x2,fs,hsr,hsfrac);
 
 
@@ -239,11 +281,11 @@ public:
 		//And getting delayed back
 		osc1mix = xmodd.feedReturn(osc1mix);
 
-		if(osc2Pul)
+		if(Osc2Pul)
 			osc2mix += o2p.getValue(x2,pwcalc) + o2p.aliasReduction();
-		if(osc2Saw)
+		if(Osc2Saw)
 			osc2mix += o2s.getValue(x2) + o2s.aliasReduction();
-		else if(!osc2Pul)
+		else if(!Osc2Pul)
 			osc2mix = o2t.getValue(x2) + o2t.aliasReduction();
 
 		//mixing
@@ -26,33 +26,51 @@
 #include "AdsrEnvelope.h"
 #include "Filter.h"
 #include "Decimator.h"
-#include "APInterpolator.h"
 
-class ObxdVoice
+//Members are grouped by how often the sample loop touches them, running state first,
+//then the parameters it reads and last what only notes and parameter changes use
+//Motherboard starts every voice on a cache line
+class alignas(64) ObxdVoice
 {
+public:
+	//the filter lfo lags by the oscillator delay, Motherboard keeps this much lfo history for all voices
+	const static int LFO_DELAY = Samples*2-1;
+	//running state
+	bool Active;
+	bool shouldProcessed;
+	float lfoIn;
+	//lfoIn from LFO_DELAY samples ago
+	float lfoDelayedIn;
+	float lfoVibratoIn;
+	float pitchWheel;
+	float prtst;
 private:
-	float SampleRate;
-	float sampleRateInv;
-	float Volume;
-	float port;
-	float velocityValue;
-
-	float d1,d2;
-	float c1,c2;
-
-	bool hq;
-
-	//JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ObxdVoice)
+	float d2;
+	float c1;
+	//control rate state, see setControlInterval
+	enum { CTL_NOTE, CTL_FENV, CTL_AMP, CTL_CUTOFF, CTL_PW1, CTL_PW2, CTL_PTO1, CTL_PTO2, CTL_COUNT };
+	float ctl[CTL_COUNT],ctlStep[CTL_COUNT];
+	int ctlCount;
+	bool ctlSnap;
+	//last delay line output, read by the next control tick
+	float ctlFenvDelayed;
 public:
-	bool sustainHold;
-	//bool resetAdsrsOnAttack;
-
 	AdsrEnvelope env;
 	AdsrEnvelope fenv;
-	ObxdOscillatorB osc;
 	Filter flt;
+	DelayLine<Samples*2> lenvd,fenvd;
+	NoiseGen ng;
+	ObxdOscillatorB osc;
 
-	Random ng;
+	//parameters read every sample
+private:
+	float sampleRateInv;
+	float velocityValue;
+	float controlIntervalInv;
+public:
+	//1 runs modulation at audio rate, above 1 it is computed every controlInterval samples
+	int controlInterval;
+	int midiIndx;
 
 	float vamp,vflt;
 
@@ -73,22 +91,10 @@ public:
 
 	float brightCoef;
 
-	int midiIndx;
-
-	bool Active;
-	bool shouldProcessed;
-
 	float fltKF;
 
 	float porta;
-	float prtst;
-
-	float cutoffwas,envelopewas;
-
-	float lfoIn;
-	float lfoVibratoIn;
 
-	float pitchWheel;
 	float pitchWheelAmt;
 	bool pitchWheelOsc2Only;
 
@@ -96,7 +102,6 @@ public:
 	bool lfoo1,lfoo2,lfof;
 	bool lfopw1,lfopw2;
 
-	bool Oversample;
 	bool selfOscPush;
 
 	float envpitchmod;
@@ -108,43 +113,36 @@ public:
 
 	bool invertFenv;
 
-
-	bool fourpole;
-
-
-	DelayLine<Samples*2> lenvd,fenvd,lfod;
-
-	ApInterpolator ap;
-	float oscpsw;
+	//notes and parameter changes only
+private:
+	float SampleRate;
+	//JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ObxdVoice)
+public:
+	bool sustainHold;
 	int legatoMode;
 	float briHold;
 
 	ObxdVoice() 
-		: ap()
 	{
-		hq = false;
 		selfOscPush = false;
 		pitchModBoth = false;
 		pwOfs = 0 ;
 		invertFenv = false;
 		pwEnvBoth = false;
-		ng = Random(Random::getSystemRandom().nextInt64());
+		ng.seed(Random::getSystemRandom().nextInt64());
 		sustainHold = false;
 		shouldProcessed = false;
 		vamp=vflt=0;
 		velocityValue=0;
 		lfoVibratoIn=0;
-		fourpole = false;
 		legatoMode = 0;
 		brightCoef =briHold= 1;
 		envpitchmod = 0;
 		pwenvmod = 0;
-		oscpsw = 0;
-		cutoffwas = envelopewas=0;
-		Oversample= false;
-		c1=c2=d1=d2=0;
+		c1=d2=0;
 		pitchWheel=pitchWheelAmt=0;
 		lfoIn=0;
+		lfoDelayedIn=0;
 		PortaDetuneAmt=0;
 		FltDetAmt=0;
 		levelDetuneAmt=0;
@@ -160,6 +158,13 @@ public:
 		FenvDetune = Random::getSystemRandom().nextFloat()-0.5;
 		FltDetune = Random::getSystemRandom().nextFloat()-0.5;
 		PortaDetune =Random::getSystemRandom().nextFloat()-0.5;
+		controlInterval = 1;
+		controlIntervalInv = 1;
+		for(int i = 0 ; i < CTL_COUNT;i++)
+			ctl[i] = ctlStep[i] = 0;
+		ctlCount = 0;
+		ctlSnap = true;
+		ctlFenvDelayed = 0;
 	//	lenvd=new DelayLine(Samples*2);
 	//	fenvd=new DelayLine(Samples*2);
 	}
@@ -169,34 +174,45 @@ public:
 	//	delete fenvd;
 	}
 	inline float ProcessSample()
+	{
+		float cutoffIndex,cutoffNoise,envVal;
+		float x1 = processPreFilter(cutoffIndex,cutoffNoise,envVal);
+		float cutoffcalc = calcCutoff(cutoffIndex,cutoffNoise);
+		x1 = flt.process(x1,(cutoffcalc)); 
+		x1 *= (envVal);
+		return x1;
+	}
+	//Everything up to the filter input
+	//Cutoff pitch is returned unexponentiated so it can be computed in lanes
+	//At control rate it is returned in Hz, see cutoffFromIndex
+	inline float processPreFilter(float& cutoffIndex,float& cutoffNoise,float& envVal)
+	{
+		if(controlInterval > 1)
+			return processPreFilterControlRate(cutoffIndex,cutoffNoise,envVal);
+		const float fenvSample = fenv.processSample();
+		return processPreFilter(fenvSample,env.processSample(),cutoffIndex,cutoffNoise,envVal);
+	}
+	//Audio rate body, takes the envelope samples so blocks can compute them ahead
+	inline float processPreFilter(float fenvSample,float envSample,float& cutoffIndex,float& cutoffNoise,float& envVal)
 	{
 		//portamento on osc input voltage
 		//implements rc circuit
 		float ptNote  =tptlpupw(prtst, midiIndx-81, porta * (1+PortaDetune*PortaDetuneAmt),sampleRateInv);
 		osc.notePlaying = ptNote;
 		//both envelopes and filter cv need a delay equal to osc internal delay
-		float lfoDelayed = lfod.feedReturn(lfoIn);
 		//filter envelope undelayed
-		float envm = fenv.processSample() * (1 - (1-velocityValue)*vflt);
+		float envm = fenvSample * (1 - (1-velocityValue)*vflt);
 		if(invertFenv)
 			envm = -envm;
 		//filter exp cutoff calculation
-		float cutoffcalc = jmin(
-			getPitch(
-			(lfof?lfoDelayed*lfoa1:0)+
+		cutoffIndex =
+			(lfof?lfoDelayedIn*lfoa1:0)+
 			cutoff+
 			FltDetune*FltDetAmt+
 			fenvamt*fenvd.feedReturn(envm)+
-			-45 + (fltKF*(ptNote+40))
-			)
-			//noisy filter cutoff
-			+(ng.nextFloat()-0.5f)*3.5f
-			, (flt.SampleRate*0.5f-120.0f));//for numerical stability purposes
-
-		//limit our max cutoff on self osc to prevent alising
-		if(selfOscPush)
-			cutoffcalc = jmin(cutoffcalc,19000.0f);
-
+			-45 + (fltKF*(ptNote+40));
+		//noisy filter cutoff
+		cutoffNoise = ng.next()*3.5f;
 
 		//PW modulation
 		osc.pw1 = (lfopw1?(lfoIn * lfoa2):0) + (pwEnvBoth?(pwenvmod * envm) : 0);
@@ -209,8 +225,76 @@ public:
 
 
 		//variable sort magic - upsample trick
-		float envVal = lenvd.feedReturn(env.processSample() * (1 - (1-velocityValue)*vamp));
+		envVal = lenvd.feedReturn(envSample * (1 - (1-velocityValue)*vamp));
 
+		return processOscillator();
+	}
+	//Portamento, envelopes and the modulation sums run once per control interval and are ramped
+	//linearly in between, the cutoff exponential included
+	//Oscillators, noise and the filter still run every sample, the delay lines are still fed
+	//every sample so amp and filter modulation stay aligned with the oscillator delay
+	inline float processPreFilterControlRate(float& cutoffHz,float& cutoffNoise,float& envVal)
+	{
+		if(ctlCount == 0)
+			controlTick();
+		ctlCount--;
+		for(int i = 0 ; i < CTL_COUNT;i++)
+			ctl[i] += ctlStep[i];
+		osc.notePlaying = ctl[CTL_NOTE];
+		osc.pw1 = ctl[CTL_PW1];
+		osc.pw2 = ctl[CTL_PW2];
+		osc.pto1 = ctl[CTL_PTO1];
+		osc.pto2 = ctl[CTL_PTO2];
+		ctlFenvDelayed = fenvd.feedReturn(ctl[CTL_FENV]);
+		envVal = lenvd.feedReturn(ctl[CTL_AMP]);
+		cutoffHz = ctl[CTL_CUTOFF];
+		cutoffNoise = ng.next()*3.5f;
+		return processOscillator();
+	}
+	//Computes the modulation values at the end of the next control interval
+	//Envelopes are still stepped per sample, their one pole coefficients do not scale to longer steps
+	inline void controlTick()
+	{
+		float target[CTL_COUNT];
+		const float ptNote = tptlpupw(prtst, midiIndx-81, porta * (1+PortaDetune*PortaDetuneAmt),sampleRateInv*controlInterval);
+		float fenvBuf[32],envBuf[32];
+		fenv.processBlock(fenvBuf,controlInterval);
+		env.processBlock(envBuf,controlInterval);
+		const float fenvVal = fenvBuf[controlInterval-1];
+		const float envVal = envBuf[controlInterval-1];
+		float envm = fenvVal * (1 - (1-velocityValue)*vflt);
+		if(invertFenv)
+			envm = -envm;
+		target[CTL_NOTE] = ptNote;
+		target[CTL_FENV] = envm;
+		target[CTL_AMP] = envVal * (1 - (1-velocityValue)*vamp);
+		target[CTL_CUTOFF] = getPitch(
+			(lfof?lfoDelayedIn*lfoa1:0)+
+			cutoff+
+			FltDetune*FltDetAmt+
+			fenvamt*ctlFenvDelayed+
+			-45 + (fltKF*(ptNote+40)),osc.pitchPrecision);
+		target[CTL_PW1] = (lfopw1?(lfoIn * lfoa2):0) + (pwEnvBoth?(pwenvmod * envm) : 0);
+		target[CTL_PW2] = (lfopw2?(lfoIn * lfoa2):0) + pwenvmod * envm + pwOfs;
+		target[CTL_PTO1] = (!pitchWheelOsc2Only? (pitchWheel*pitchWheelAmt):0 ) + ( lfoo1?(lfoIn * lfoa1):0) + (pitchModBoth?(envpitchmod * envm):0) + lfoVibratoIn;
+		target[CTL_PTO2] = (pitchWheel *pitchWheelAmt) + (lfoo2?lfoIn*lfoa1:0) + (envpitchmod * envm) + lfoVibratoIn;
+		for(int i = 0 ; i < CTL_COUNT;i++)
+		{
+			//a waking voice starts on its targets instead of ramping from stale values
+			if(ctlSnap)
+			{
+				ctl[i] = target[i];
+				ctlStep[i] = 0;
+			}
+			else
+				ctlStep[i] = (target[i] - ctl[i]) * controlIntervalInv;
+		}
+		ctlSnap = false;
+		ctlCount = controlInterval;
+	}
+	//Oscillators, dc blocking and brightness
+	inline float processOscillator()
+	{
 		float oscps = osc.ProcessSample() * (1 - levelDetuneAmt*levelDetune);
 
 
@@ -218,13 +302,119 @@ public:
 
 		float x1 = oscps;
 		x1 = tptpc(d2,x1,brightCoef);
-		if(fourpole)
-			x1 = flt.Apply4Pole(x1,(cutoffcalc)); 
-		else
-			x1 = flt.Apply(x1,(cutoffcalc)); 
-		x1 *= (envVal);
 		return x1;
 	}
+	//Cutoff in Hz from the value processPreFilter returned
+	inline float cutoffFromIndex(float cutoffIndex)
+	{
+		return controlInterval > 1 ? cutoffIndex : getPitch(cutoffIndex,osc.pitchPrecision);
+	}
+	inline float calcCutoff(float cutoffIndex,float cutoffNoise)
+	{
+		float cutoffcalc = jmin(cutoffFromIndex(cutoffIndex) + cutoffNoise,
+			(flt.SampleRate*0.5f-120.0f));//for numerical stability purposes
+
+		//limit our max cutoff on self osc to prevent alising
+		if(selfOscPush)
+			cutoffcalc = jmin(cutoffcalc,19000.0f);
+		return cutoffcalc;
+	}
+	//Runs processPreFilter for numSamples voice rate samples, outputs are written every stride floats
+	//Controls are read once per output sample, osShift is log2 of the oversampling factor
+	//lfo has to be readable from lfo[-LFO_DELAY]
+	//Returns how many samples were processed before economy mode put the voice to sleep
+	inline int processBlockPreFilter(float* in,float* cutIdx,float* cutNoise,float* envOut,int stride,int numSamples,
+		const float* lfo,const float* vib,const float* cutoffs,const float* pitchWheels,int osShift,bool economy)
+	{
+		if(controlInterval == 1)
+			return processBlockPreFilterAudioRate(in,cutIdx,cutNoise,envOut,stride,numSamples,lfo,vib,cutoffs,pitchWheels,osShift,economy);
+		for(int i = 0 ; i < numSamples;i++)
+		{
+			if(economy)
+			{
+				checkAdsrState();
+				//only a note on can wake us up, so the rest of the block is silent
+				if(!shouldProcessed)
+					return i;
+			}
+			lfoIn = lfo[i];
+			lfoDelayedIn = lfo[i-LFO_DELAY];
+			lfoVibratoIn = vib[i];
+			cutoff = cutoffs[i>>osShift];
+			pitchWheel = pitchWheels[i>>osShift];
+			in[i*stride] = processPreFilter(cutIdx[i*stride],cutNoise[i*stride],envOut[i*stride]);
+		}
+		return numSamples;
+	}
+	//Envelopes run a span at a time ahead of the rest, see AdsrEnvelope::processBlock
+	//In economy mode the filter envelope stops where the amp envelope fell silent, as per sample
+	inline int processBlockPreFilterAudioRate(float* in,float* cutIdx,float* cutNoise,float* envOut,int stride,int numSamples,
+		const float* lfo,const float* vib,const float* cutoffs,const float* pitchWheels,int osShift,bool economy)
+	{
+		const int Span = 64;
+		float envBuf[Span],fenvBuf[Span];
+		for(int start = 0 ; start < numSamples;start += Span)
+		{
+			const int n = jmin(Span,numSamples-start);
+			if(economy)
+			{
+				checkAdsrState();
+				//only a note on can wake us up, so the rest of the block is silent
+				if(!shouldProcessed)
+					return start;
+			}
+			const int active = env.processBlock(envBuf,n);
+			const int run = economy ? active : n;
+			fenv.processBlock(fenvBuf,run);
+			for(int j = 0 ; j < run;j++)
+			{
+				const int i = start+j;
+				lfoIn = lfo[i];
+				lfoDelayedIn = lfo[i-LFO_DELAY];
+				lfoVibratoIn = vib[i];
+				cutoff = cutoffs[i>>osShift];
+				pitchWheel = pitchWheels[i>>osShift];
+				in[i*stride] = processPreFilter(fenvBuf[j],envBuf[j],cutIdx[i*stride],cutNoise[i*stride],envOut[i*stride]);
+			}
+			if(run < n)
+			{
+				checkAdsrState();
+				return start+run;
+			}
+		}
+		return numSamples;
+	}
+	//Scalar filter and amp stage for samples prepared by processBlockPreFilter
+	//The filter variant cannot change within a block, so it is picked once and inlined into the loop
+	inline void processBlockFilter(float* out,const float* in,const float* cutIdx,const float* cutNoise,const float* envIn,int stride,int numSamples)
+	{
+		if(flt.isFourPole())
+			processBlockFilter<&Filter::Apply4Pole>(out,in,cutIdx,cutNoise,envIn,stride,numSamples);
+		else if(flt.bandPassSw)
+		{
+			if(flt.selfOscPush)
+				processBlockFilter<&Filter::Apply<true,true> >(out,in,cutIdx,cutNoise,envIn,stride,numSamples);
+			else
+				processBlockFilter<&Filter::Apply<true,false> >(out,in,cutIdx,cutNoise,envIn,stride,numSamples);
+		}
+		else
+		{
+			if(flt.selfOscPush)
+				processBlockFilter<&Filter::Apply<false,true> >(out,in,cutIdx,cutNoise,envIn,stride,numSamples);
+			else
+				processBlockFilter<&Filter::Apply<false,false> >(out,in,cutIdx,cutNoise,envIn,stride,numSamples);
+		}
+	}
+	template<float (Filter::*Apply)(float,float)> inline void processBlockFilter(float* out,const float* in,const float* cutIdx,const float* cutNoise,const float* envIn,int stride,int numSamples)
+	{
+		for(int i = 0 ; i < numSamples;i++)
+		{
+			float x1 = in[i*stride];
+			float cutoffcalc = calcCutoff(cutIdx[i*stride],cutNoise[i*stride]);
+			x1 = (flt.*Apply)(x1,(cutoffcalc)); 
+			out[i] = x1*envIn[i*stride];
+		}
+	}
 	void setBrightness(float val)
 	{
 		briHold = val;
@@ -236,6 +426,8 @@ public:
 		env.setUniqueDeriviance(1 + EnvDetune*d);
 		fenv.setUniqueDeriviance(1 + FenvDetune*d);
 	}
+	//any oversampling factor uses the half band tables, the output passband is below half the voice rate
+	//from 4x on the early decimation stages clear what the tables leave above it
 	void setHQ(bool hq)
 	{
 		if(hq)
@@ -247,6 +439,20 @@ public:
 			osc.removeDecimation();
 		}
 	}
+	//cutoff and oscillator noise streams, for renders that have to repeat
+	void seedNoise(uint64_t seed)
+	{
+		ng.seed(seed);
+		osc.seedNoise(seed+1);
+	}
+	//interval in samples, 1 keeps everything at audio rate
+	void setControlInterval(int interval)
+	{
+		controlInterval = jlimit(1,32,interval);
+		controlIntervalInv = 1.0f / controlInterval;
+		ctlCount = 0;
+		ctlSnap = true;
+	}
 	void setSampleRate(float sr)
 	{
 		flt.setSampleRate(sr);
@@ -266,6 +472,13 @@ public:
 		env.ResetEnvelopeState();
 		fenv.ResetEnvelopeState();
 	}
+	//ends an inaudible release early, as if the envelope had run out
+	//the delay lines are left as they are, the next NoteOn clears them
+	void sleep()
+	{
+		ResetEnvelope();
+		shouldProcessed = false;
+	}
 	void NoteOn(int mididx,float velocity)
 	{
 		if(!shouldProcessed)
@@ -275,7 +488,10 @@ public:
 			lenvd.fillZeroes();
 			fenvd.fillZeroes();
 			ResetEnvelope();
+			ctlCount = 0;
+			ctlSnap = true;
 		}
+		flt.snapCoefficient();
 		shouldProcessed = true;
 		if(velocity!=-0.5)
 			velocityValue = velocity;
@@ -0,0 +1,98 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+//Bounded lock-free queue of engine parameter changes
+//Any thread may push, only the audio thread pops
+//Each cell carries a sequence number so producers claim slots without locks
+class ParamQueue
+{
+public:
+	struct Entry
+	{
+		int index;
+		float value;
+		int sampleOffset;
+	};
+	//must be a power of two
+	const static int Capacity = 1024;
+private:
+	struct Cell
+	{
+		std::atomic<size_t> seq;
+		Entry entry;
+	};
+	Cell cells[Capacity];
+	std::atomic<size_t> tail;
+	size_t head;
+public:
+	ParamQueue()
+	{
+		for(int i = 0 ; i < Capacity;i++)
+			cells[i].seq.store(i,std::memory_order_relaxed);
+		tail.store(0,std::memory_order_relaxed);
+		head = 0;
+	}
+	//returns false when the queue is full
+	bool push(int index,float value,int sampleOffset)
+	{
+		size_t pos = tail.load(std::memory_order_relaxed);
+		Cell* c;
+		for(;;)
+		{
+			c = &cells[pos & (Capacity-1)];
+			size_t seq = c->seq.load(std::memory_order_acquire);
+			ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+			if(dif == 0)
+			{
+				if(tail.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+					break;
+			}
+			else if(dif < 0)
+				return false;
+			else
+				pos = tail.load(std::memory_order_relaxed);
+		}
+		c->entry.index = index;
+		c->entry.value = value;
+		c->entry.sampleOffset = sampleOffset;
+		c->seq.store(pos+1,std::memory_order_release);
+		return true;
+	}
+	//consumer side, audio thread only
+	inline bool peek(Entry& e) const
+	{
+		const Cell& c = cells[head & (Capacity-1)];
+		if(c.seq.load(std::memory_order_acquire) != head+1)
+			return false;
+		e = c.entry;
+		return true;
+	}
+	inline void pop()
+	{
+		cells[head & (Capacity-1)].seq.store(head+Capacity,std::memory_order_release);
+		head++;
+	}
+};
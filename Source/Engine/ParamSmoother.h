@@ -31,24 +31,47 @@ class ParamSmoother
 		float steepValue;
 		float integralValue;
 		float srCor;
+		//set once a step leaves the value unchanged, every later step would too
+		bool converged;
 	public :
 	ParamSmoother()
 	{
 		steepValue=integralValue=0;
 		srCor=1;
+		converged = false;
 	};
 	float smoothStep()
 	{
-		integralValue = integralValue + ( steepValue - integralValue)*PSSC*srCor + dc;
+		if(converged)
+			return integralValue;
+		float next = integralValue + ( steepValue - integralValue)*PSSC*srCor + dc;
+		converged = next == integralValue;
+		integralValue = next;
 		return integralValue;
 	}
+	//fills a shared control buffer with the next numSamples steps
+	void smoothBlock(float* out,int numSamples)
+	{
+		int i = 0;
+		for(; i < numSamples && !converged;i++)
+			out[i] = smoothStep();
+		for(; i < numSamples;i++)
+			out[i] = integralValue;
+	}
+	bool isConverged() const
+	{
+		return converged;
+	}
 	void setSteep(float value)
 	{
+		if(value != steepValue)
+			converged = false;
 		steepValue = value;
 	}
 	void setSampleRate(float sr)
 	{
 		srCor = sr / 44000;
+		converged = false;
 	}
 
 };
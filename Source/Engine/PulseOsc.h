@@ -23,27 +23,22 @@
  */
 #pragma once
 #include "SynthEngine.h"
-#include "BlepData.h"
+#include "BlepTable.h"
 class PulseOsc 
 {
 	DelayLine<Samples> del1;
 	bool pw1t;
-	float buffer1[Samples*2];
+	BlepBuffer buffer1;
 	const int hsam;
 	const int n;
-	float const * blepPTR;
-	int bP1;
+	BlepTable const * blepPTR;
 public:
 	PulseOsc() : hsam(Samples)
 		, n(Samples*2)
 	{
 	//	del1 = new DelayLine(hsam);
 		pw1t = false;
-		bP1=0;
-		//buffer1= new float[n];
-		for(int i = 0 ; i < n ; i++)
-			buffer1[i]=0;
-		blepPTR = blep;
+		blepPTR = &BlepTable::getBlep();
 	}
 	~PulseOsc()
 	{
@@ -52,15 +47,15 @@ public:
 	}
 	inline void setDecimation()
 	{
-		blepPTR = blepd2;
+		blepPTR = &BlepTable::getBlepD2();
 	}
 	inline void removeDecimation()
 	{
-		blepPTR = blep;
+		blepPTR = &BlepTable::getBlep();
 	}
 	inline float aliasReduction()
 	{
-		return -getNextBlep(buffer1,bP1);
+		return -buffer1.next();
 	}
 	inline void processMaster(float x,float delta,float pulseWidth,float pulseWidthWas)
 	{
@@ -69,20 +64,20 @@ public:
 		{
 			x -= 1.0f;
 			if(pw1t)
-				mixInImpulseCenter(buffer1,bP1,x/delta, 1);
+				mixInImpulseCenter(x/delta, 1);
 			pw1t=false;
 		}
 		if((!pw1t)&& (x >= pulseWidth)&&(x - summated <=pulseWidth))
 		{
 			pw1t=true;
 			float frac  =(x-pulseWidth) / summated;
-			mixInImpulseCenter(buffer1,bP1,frac,-1);
+			mixInImpulseCenter(frac,-1);
 		}
 		if((pw1t) && x >= 1.0f)
 		{
 			x-=1.0f;
 			if(pw1t)
-				mixInImpulseCenter(buffer1,bP1,x/delta, 1);
+				mixInImpulseCenter(x/delta, 1);
 			pw1t=false;
 		}
 
@@ -115,7 +110,7 @@ public:
 			if(((!hardSyncReset)||(x/delta > hardSyncFrac)))//de morgan processed equation
 			{
 				if(pw1t)
-					mixInImpulseCenter(buffer1,bP1,x/delta, 1);
+					mixInImpulseCenter(x/delta, 1);
 				pw1t=false;
 			}
 			else
@@ -131,7 +126,7 @@ public:
 			if(((!hardSyncReset)||(frac > hardSyncFrac)))//de morgan processed equation
 			{
 				//transition to 1
-				mixInImpulseCenter(buffer1,bP1,frac,-1);
+				mixInImpulseCenter(frac,-1);
 			}
 			else
 			{
@@ -146,7 +141,7 @@ public:
 			if(((!hardSyncReset)||(x/delta > hardSyncFrac)))//de morgan processed equation
 			{
 				if(pw1t)
-					mixInImpulseCenter(buffer1,bP1,x/delta, 1);
+					mixInImpulseCenter(x/delta, 1);
 				pw1t=false;
 			}
 			else
@@ -159,36 +154,13 @@ public:
 		{
 			//float fracMaster = (delta * hardSyncFrac);
 			float trans =(pw1t?1:0);
-			mixInImpulseCenter(buffer1,bP1,hardSyncFrac,trans);
+			mixInImpulseCenter(hardSyncFrac,trans);
 			pw1t = false;
 		}
 
 	}
-	inline void mixInImpulseCenter(float * buf,int& bpos,float offset, float scale) 
+	inline void mixInImpulseCenter(float offset, float scale)
 	{
-		int lpIn =(int)(B_OVERSAMPLING*(offset));
-		float frac = offset * B_OVERSAMPLING - lpIn;
-		float f1 = 1.0f-frac;
-		for(int i = 0 ; i < Samples;i++)
-		{
-			float mixvalue = (blepPTR[lpIn]*f1+blepPTR[lpIn+1]*(frac));
-			buf[(bpos+i)&(n-1)]  += mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
-		for(int i = Samples ; i <n;i++)
-		{
-			float mixvalue = (blepPTR[lpIn]*f1+blepPTR[lpIn+1]*(frac));
-			buf[(bpos+i)&(n-1)]  -= mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
-	}
-	inline float getNextBlep(float* buf,int& bpos) 
-	{
-		buf[bpos]= 0.0f;
-		bpos++;
-
-		// Wrap pos
-		bpos&=(n-1);
-		return buf[bpos];
+		buffer1.mixIn(*blepPTR,offset,scale);
 	}
 };
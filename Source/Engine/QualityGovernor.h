@@ -0,0 +1,125 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <math.h>
+//Quality tiers the governor steps through, each keeps the reductions of the ones before
+//QUALITY_FULL everything as set
+//QUALITY_NO_OVERSAMPLING the HQ switch is ignored
+//QUALITY_VOICE_CAP new notes get half of the voice count setting, the voices above fade out
+//QUALITY_CHEAP_KERNELS fast pitch and prewarp polynomials, modulation at control rate
+enum { QUALITY_FULL = 0, QUALITY_NO_OVERSAMPLING, QUALITY_VOICE_CAP, QUALITY_CHEAP_KERNELS, QUALITY_TIER_COUNT };
+//Picks a quality tier from how long blocks take against their real time budget
+//A tier is dropped as soon as the average load is high or blocks overrun back to back,
+//it is only given back after the load has stayed low for a while
+class QualityGovernor
+{
+private:
+	double sampleRate;
+	//load averaged over about LOAD_MS, restarted when the tier changes
+	float load;
+	bool restart;
+	//blocks in a row that took longer than their budget
+	int overruns;
+	int tier;
+	int maxTier;
+	//seconds since the tier last changed
+	float sinceChange;
+	const static int DOWN_PERCENT = 80;
+	const static int UP_PERCENT = 40;
+	const static int LOAD_MS = 300;
+	const static int DOWN_HOLD_MS = 100;
+	const static int UP_HOLD_MS = 2000;
+	const static int MAX_OVERRUNS = 2;
+public:
+	QualityGovernor()
+	{
+		sampleRate = 44100;
+		load = 0;
+		restart = true;
+		overruns = 0;
+		tier = QUALITY_FULL;
+		maxTier = QUALITY_FULL;
+		sinceChange = 0;
+	}
+	void setSampleRate(double sr)
+	{
+		sampleRate = sr;
+	}
+	//lowest tier the governor may go to, QUALITY_FULL turns it off
+	void setMaxTier(int t)
+	{
+		maxTier = t < QUALITY_FULL ? QUALITY_FULL : (t >= QUALITY_TIER_COUNT ? QUALITY_TIER_COUNT-1 : t);
+		if(tier > maxTier)
+			tier = maxTier;
+	}
+	int getTier() const
+	{
+		return tier;
+	}
+	//average fraction of the real time budget blocks take
+	float getLoad() const
+	{
+		return load;
+	}
+	//call after every block with the seconds it took, returns true when the tier changed
+	bool update(double seconds,int numSamples)
+	{
+		if(numSamples <= 0 || maxTier == QUALITY_FULL)
+			return false;
+		const float budget = (float)(numSamples / sampleRate);
+		const float blockLoad = (float)(seconds / budget);
+		if(restart)
+			load = blockLoad;
+		else
+			load += (blockLoad - load) * (1 - expf(-budget * 1000 / LOAD_MS));
+		restart = false;
+		overruns = blockLoad > 1 ? overruns+1 : 0;
+		sinceChange += budget;
+		if(tier < maxTier && sinceChange * 1000 > DOWN_HOLD_MS && (load * 100 > DOWN_PERCENT || overruns >= MAX_OVERRUNS))
+		{
+			tier++;
+			sinceChange = 0;
+			restart = true;
+			return true;
+		}
+		if(tier > QUALITY_FULL && sinceChange * 1000 > UP_HOLD_MS && load * 100 < UP_PERCENT)
+		{
+			tier--;
+			sinceChange = 0;
+			restart = true;
+			return true;
+		}
+		return false;
+	}
+	static const char* getTierName(int t)
+	{
+		switch(t)
+		{
+			case QUALITY_NO_OVERSAMPLING: return "no oversampling";
+			case QUALITY_VOICE_CAP: return "voices capped";
+			case QUALITY_CHEAP_KERNELS: return "cheap kernels";
+			default: return "full";
+		}
+	}
+};
@@ -0,0 +1,225 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <atomic>
+#include "SynthEngine.h"
+#if defined(__SSE__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OBXD_RENDER_SSE 1
+#include <xmmintrin.h>
+#endif
+//Pre-spawned worker threads used to render parts of a block in parallel
+//The audio thread posts a part to each worker through atomics and renders part 0 itself.
+//Parts no worker has picked up by then are taken back and rendered on the audio thread,
+//so it only ever waits on parts that are already running and never touches a lock.
+//Workers spin while a host block is being rendered, sleep through most of the gap to
+//the next one and spin again from just before it is expected. A post to a sleeping
+//worker wakes it, if the host stops sending blocks the workers fall back to polling.
+class RenderPool
+{
+public:
+	const static int MAX_WORKERS = 7;
+	const static int MAX_PARTS = MAX_WORKERS + 1;
+	typedef void (*PartFunc)(void* context,int part);
+private:
+	//workers start spinning this long before the next block is expected
+	const static int WAKE_EARLY_MS = 1;
+	//and give up spinning this long after it was expected
+	const static int IDLE_MS = 2;
+	//longest single sleep, bounds the wake up delay after the host restarts
+	const static int MAX_SLEEP_MS = 5;
+
+	static inline void pause()
+	{
+#ifdef OBXD_RENDER_SSE
+		_mm_pause();
+#endif
+	}
+
+	class Worker : public Thread
+	{
+	public:
+		RenderPool& pool;
+		std::atomic<int> part;
+		//set around wait(), a post checks it after storing part and wakes the worker
+		std::atomic<bool> sleeping;
+		Worker(RenderPool& p) : Thread("Obxd render worker"), pool(p)
+		{
+			part = -1;
+			sleeping = false;
+		}
+		int claim()
+		{
+			//plain load while idle so the spin does not keep the line exclusive
+			if(part.load(std::memory_order_relaxed) < 0)
+				return -1;
+			return part.exchange(-1,std::memory_order_acquire);
+		}
+		//the recheck after raising sleeping pairs with the post in RenderPool::run,
+		//either the worker sees the part or the poster sees the flag and notifies
+		void waitForPost(int ms)
+		{
+			sleeping.store(true);
+			if(part.load() < 0 && !pool.inBlock.load())
+				wait(ms);
+			sleeping.store(false,std::memory_order_relaxed);
+		}
+		void run() override
+		{
+			while(!threadShouldExit())
+			{
+				int p;
+				while((p = claim()) < 0)
+				{
+					if(threadShouldExit())
+						return;
+					if(pool.inBlock.load(std::memory_order_relaxed))
+					{
+						pause();
+						continue;
+					}
+					const double now = Time::getMillisecondCounterHiRes();
+					const double next = pool.blockMs.load(std::memory_order_relaxed) + pool.periodMs.load(std::memory_order_relaxed);
+					if(now < next - WAKE_EARLY_MS)
+						waitForPost(jlimit(1,(int)MAX_SLEEP_MS,(int)(next - WAKE_EARLY_MS - now)));
+					else if(now > next + IDLE_MS)
+						waitForPost(MAX_SLEEP_MS);
+					else
+						pause();
+				}
+#ifdef OBXD_RENDER_SSE
+				//render with the audio thread's denormal and rounding modes
+				if(_mm_getcsr() != pool.csr)
+					_mm_setcsr(pool.csr);
+#endif
+				pool.func(pool.context,p);
+				pool.remaining.fetch_sub(1,std::memory_order_release);
+			}
+		}
+	};
+
+	Worker* workers[MAX_WORKERS];
+	int numWorkers;
+	PartFunc func;
+	void* context;
+	unsigned int csr;
+	std::atomic<int> remaining;
+	//start of the last host block and the time since the one before, in ms
+	std::atomic<double> blockMs;
+	std::atomic<double> periodMs;
+	//between beginBlock and endBlock
+	std::atomic<bool> inBlock;
+	void wakeSleeping(int count)
+	{
+		for(int i = 0 ; i < count;i++)
+			if(workers[i]->sleeping.load())
+				workers[i]->notify();
+	}
+public:
+	RenderPool()
+	{
+		numWorkers = 0;
+		func = NULL;
+		context = NULL;
+		csr = 0;
+		remaining = 0;
+		blockMs = 0;
+		periodMs = 0;
+		inBlock = false;
+		for(int i = 0 ; i < MAX_WORKERS;i++)
+			workers[i] = NULL;
+	}
+	~RenderPool()
+	{
+		setNumWorkers(0);
+	}
+	//not for the audio thread, threads are created and joined here
+	void setNumWorkers(int count)
+	{
+		count = jlimit(0,(int)MAX_WORKERS,count);
+		if(count == numWorkers)
+			return;
+		for(int i = 0 ; i < numWorkers;i++)
+		{
+			workers[i]->signalThreadShouldExit();
+			workers[i]->notify();
+			workers[i]->stopThread(1000);
+			delete workers[i];
+			workers[i] = NULL;
+		}
+		numWorkers = count;
+		for(int i = 0 ; i < numWorkers;i++)
+		{
+			workers[i] = new Worker(*this);
+			workers[i]->startThread(10);
+		}
+	}
+	int getNumWorkers() const
+	{
+		return numWorkers;
+	}
+	//once per host block around all of its run() calls, workers keep spinning in between
+	//and time their sleep from the host block period
+	void beginBlock()
+	{
+		if(numWorkers == 0)
+			return;
+		const double now = Time::getMillisecondCounterHiRes();
+		periodMs.store(now - blockMs.load(std::memory_order_relaxed),std::memory_order_relaxed);
+		blockMs.store(now,std::memory_order_relaxed);
+		inBlock.store(true);
+		wakeSleeping(numWorkers);
+	}
+	void endBlock()
+	{
+		inBlock.store(false,std::memory_order_relaxed);
+	}
+	//runs f(context,part) for part in [0,parts), parts <= numWorkers+1
+	//part 0 runs on the calling thread, returns when every part is done
+	void run(PartFunc f,void* ctx,int parts)
+	{
+		func = f;
+		context = ctx;
+#ifdef OBXD_RENDER_SSE
+		csr = _mm_getcsr();
+#endif
+		remaining.store(parts-1,std::memory_order_relaxed);
+		for(int i = 1 ; i < parts;i++)
+			workers[i-1]->part.store(i);
+		//only when a host runs without beginBlock or sends a block early
+		wakeSleeping(parts-1);
+		f(ctx,0);
+		//take back whatever no worker has started
+		for(int i = 1 ; i < parts;i++)
+		{
+			int p = i;
+			if(workers[i-1]->part.compare_exchange_strong(p,-1,std::memory_order_relaxed))
+			{
+				f(ctx,i);
+				remaining.fetch_sub(1,std::memory_order_relaxed);
+			}
+		}
+		while(remaining.load(std::memory_order_acquire) > 0)
+			pause();
+	}
+};
@@ -23,25 +23,20 @@
  */
 #pragma once
 #include "SynthEngine.h"
-#include "BlepData.h"
+#include "BlepTable.h"
 class SawOsc 
 {
 	DelayLine<Samples> del1;
-	float buffer1[Samples*2];
+	BlepBuffer buffer1;
 	const int hsam;
 	const int n;
-	float const * blepPTR;
-	int bP1;
+	BlepTable const * blepPTR;
 public:
 	SawOsc() : hsam(Samples)
 		, n(Samples*2)
 	{
-		bP1=0;
 		//del1 = new DelayLine(hsam);
-		//buffer1= new float[n];
-		for(int i = 0 ; i < n ; i++)
-			buffer1[i]=0;
-		blepPTR = blep;
+		blepPTR = &BlepTable::getBlep();
 	}
 	~SawOsc()
 	{
@@ -50,22 +45,22 @@ public:
 	}
 	inline void setDecimation()
 	{
-		blepPTR = blepd2;
+		blepPTR = &BlepTable::getBlepD2();
 	}
 	inline void removeDecimation()
 	{
-		blepPTR = blep;
+		blepPTR = &BlepTable::getBlep();
 	}
 	inline float aliasReduction()
 	{
-		return -getNextBlep(buffer1,bP1);
+		return -buffer1.next();
 	}
 	inline void processMaster(float x,float delta)
 	{
 		if(x >= 1.0f)
 		{
 			x-=1.0f;
-			mixInImpulseCenter(buffer1,bP1,x/delta, 1);
+			mixInImpulseCenter(x/delta, 1);
 		}
 	}
 	inline float getValue(float x)
@@ -83,7 +78,7 @@ public:
 			x -= 1.0f;
 			if(((!hardSyncReset)||(x/delta > hardSyncFrac)))//de morgan processed equation
 			{
-				mixInImpulseCenter(buffer1,bP1,x/delta, 1);
+				mixInImpulseCenter(x/delta, 1);
 			}
 			else
 			{
@@ -95,34 +90,11 @@ public:
 		{
 			float fracMaster = (delta * hardSyncFrac);
 			float trans = (x-fracMaster);
-			mixInImpulseCenter(buffer1,bP1,hardSyncFrac,trans);
+			mixInImpulseCenter(hardSyncFrac,trans);
 		}
 	}
-	inline void mixInImpulseCenter(float * buf,int& bpos,float offset, float scale) 
+	inline void mixInImpulseCenter(float offset, float scale)
 	{
-		int lpIn =(int)(B_OVERSAMPLING*(offset));
-		float frac = offset * B_OVERSAMPLING - lpIn;
-		float f1 = 1.0f-frac;
-		for(int i = 0 ; i < Samples;i++)
-		{
-			float mixvalue = (blepPTR[lpIn]*f1+blepPTR[lpIn+1]*frac);
-			buf[(bpos+i)&(n-1)]  += mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
-		for(int i = Samples ; i <n;i++)
-		{
-			float mixvalue = (blepPTR[lpIn]*f1+blepPTR[lpIn+1]*frac);
-			buf[(bpos+i)&(n-1)]  -= mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
-	}
-	inline float getNextBlep(float* buf,int& bpos) 
-	{
-		buf[bpos]= 0.0f;
-		bpos++;
-
-		// Wrap pos
-		bpos&=(n-1);
-		return buf[bpos];
+		buffer1.mixIn(*blepPTR,offset,scale);
 	}
 };
@@ -0,0 +1,208 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright � 2013-2014 Filatov Vadim
+
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include <math.h>
+//Minimal float/double lane types used to run one voice per lane
+//8 lanes with AVX, 4 lanes with SSE2, 4 plain floats otherwise
+//Operations are plain IEEE ops in the same order as the scalar code,
+//so lane results match the scalar voice path bit for bit
+
+#if defined(__AVX__)
+#define OBXD_SIMD_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBXD_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+struct SimdFloat
+{
+#if defined(OBXD_SIMD_AVX)
+	static const int Lanes = 8;
+	__m256 v;
+	static inline SimdFloat load(const float* p) { SimdFloat r; r.v = _mm256_loadu_ps(p); return r; }
+	static inline SimdFloat broadcast(float x) { SimdFloat r; r.v = _mm256_set1_ps(x); return r; }
+	inline void store(float* p) const { _mm256_storeu_ps(p,v); }
+	friend inline SimdFloat operator+(SimdFloat a,SimdFloat b) { a.v = _mm256_add_ps(a.v,b.v); return a; }
+	friend inline SimdFloat operator-(SimdFloat a,SimdFloat b) { a.v = _mm256_sub_ps(a.v,b.v); return a; }
+	friend inline SimdFloat operator*(SimdFloat a,SimdFloat b) { a.v = _mm256_mul_ps(a.v,b.v); return a; }
+	friend inline SimdFloat operator/(SimdFloat a,SimdFloat b) { a.v = _mm256_div_ps(a.v,b.v); return a; }
+	//same as jmin(a,b)
+	static inline SimdFloat min(SimdFloat a,SimdFloat b) { a.v = _mm256_min_ps(b.v,a.v); return a; }
+	//same as jmax(a,b)
+	static inline SimdFloat max(SimdFloat a,SimdFloat b) { a.v = _mm256_max_ps(b.v,a.v); return a; }
+	static inline SimdFloat floor(SimdFloat a) { a.v = _mm256_floor_ps(a.v); return a; }
+	//a > b ? x : y per lane
+	static inline SimdFloat selectGreater(SimdFloat a,SimdFloat b,SimdFloat x,SimdFloat y) { x.v = _mm256_blendv_ps(y.v,x.v,_mm256_cmp_ps(a.v,b.v,_CMP_GT_OQ)); return x; }
+	//2^n for integral n in [-126,127], built in the exponent bits
+	static inline SimdFloat pow2i(SimdFloat n)
+	{
+		const __m256i i = _mm256_cvtps_epi32(n.v);
+		const __m128i bias = _mm_set1_epi32(127);
+		const __m128i lo = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(i),bias),23);
+		const __m128i hi = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(i,1),bias),23);
+		n.v = _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo),hi,1));
+		return n;
+	}
+#elif defined(OBXD_SIMD_SSE2)
+	static const int Lanes = 4;
+	__m128 v;
+	static inline SimdFloat load(const float* p) { SimdFloat r; r.v = _mm_loadu_ps(p); return r; }
+	static inline SimdFloat broadcast(float x) { SimdFloat r; r.v = _mm_set1_ps(x); return r; }
+	inline void store(float* p) const { _mm_storeu_ps(p,v); }
+	friend inline SimdFloat operator+(SimdFloat a,SimdFloat b) { a.v = _mm_add_ps(a.v,b.v); return a; }
+	friend inline SimdFloat operator-(SimdFloat a,SimdFloat b) { a.v = _mm_sub_ps(a.v,b.v); return a; }
+	friend inline SimdFloat operator*(SimdFloat a,SimdFloat b) { a.v = _mm_mul_ps(a.v,b.v); return a; }
+	friend inline SimdFloat operator/(SimdFloat a,SimdFloat b) { a.v = _mm_div_ps(a.v,b.v); return a; }
+	//same as jmin(a,b)
+	static inline SimdFloat min(SimdFloat a,SimdFloat b) { a.v = _mm_min_ps(b.v,a.v); return a; }
+	//same as jmax(a,b)
+	static inline SimdFloat max(SimdFloat a,SimdFloat b) { a.v = _mm_max_ps(b.v,a.v); return a; }
+	static inline SimdFloat floor(SimdFloat a)
+	{
+		//truncate, then step down where truncation rounded up
+		const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+		a.v = _mm_sub_ps(t,_mm_and_ps(_mm_cmpgt_ps(t,a.v),_mm_set1_ps(1.0f)));
+		return a;
+	}
+	//a > b ? x : y per lane
+	static inline SimdFloat selectGreater(SimdFloat a,SimdFloat b,SimdFloat x,SimdFloat y)
+	{
+		const __m128 m = _mm_cmpgt_ps(a.v,b.v);
+		x.v = _mm_or_ps(_mm_and_ps(m,x.v),_mm_andnot_ps(m,y.v));
+		return x;
+	}
+	//2^n for integral n in [-126,127], built in the exponent bits
+	static inline SimdFloat pow2i(SimdFloat n)
+	{
+		n.v = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n.v),_mm_set1_epi32(127)),23));
+		return n;
+	}
+#else
+	static const int Lanes = 4;
+	float v[Lanes];
+	static inline SimdFloat load(const float* p) { SimdFloat r; for(int i = 0 ; i < Lanes;i++) r.v[i] = p[i]; return r; }
+	static inline SimdFloat broadcast(float x) { SimdFloat r; for(int i = 0 ; i < Lanes;i++) r.v[i] = x; return r; }
+	inline void store(float* p) const { for(int i = 0 ; i < Lanes;i++) p[i] = v[i]; }
+	friend inline SimdFloat operator+(SimdFloat a,SimdFloat b) { for(int i = 0 ; i < Lanes;i++) a.v[i]+=b.v[i]; return a; }
+	friend inline SimdFloat operator-(SimdFloat a,SimdFloat b) { for(int i = 0 ; i < Lanes;i++) a.v[i]-=b.v[i]; return a; }
+	friend inline SimdFloat operator*(SimdFloat a,SimdFloat b) { for(int i = 0 ; i < Lanes;i++) a.v[i]*=b.v[i]; return a; }
+	friend inline SimdFloat operator/(SimdFloat a,SimdFloat b) { for(int i = 0 ; i < Lanes;i++) a.v[i]/=b.v[i]; return a; }
+	//same as jmin(a,b)
+	static inline SimdFloat min(SimdFloat a,SimdFloat b) { for(int i = 0 ; i < Lanes;i++) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]; return a; }
+	//same as jmax(a,b)
+	static inline SimdFloat max(SimdFloat a,SimdFloat b) { for(int i = 0 ; i < Lanes;i++) a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i]; return a; }
+	static inline SimdFloat floor(SimdFloat a) { for(int i = 0 ; i < Lanes;i++) a.v[i] = floorf(a.v[i]); return a; }
+	//a > b ? x : y per lane
+	static inline SimdFloat selectGreater(SimdFloat a,SimdFloat b,SimdFloat x,SimdFloat y) { for(int i = 0 ; i < Lanes;i++) x.v[i] = a.v[i] > b.v[i] ? x.v[i] : y.v[i]; return x; }
+	//2^n for integral n in [-126,127], built in the exponent bits
+	static inline SimdFloat pow2i(SimdFloat n)
+	{
+		for(int i = 0 ; i < Lanes;i++)
+		{
+			union { int32_t i; float f; } u;
+			u.i = ((int32_t)n.v[i] + 127) << 23;
+			n.v[i] = u.f;
+		}
+		return n;
+	}
+#endif
+	friend inline SimdFloat operator+(SimdFloat a,float b) { return a + broadcast(b); }
+	friend inline SimdFloat operator+(float a,SimdFloat b) { return broadcast(a) + b; }
+	friend inline SimdFloat operator-(SimdFloat a,float b) { return a - broadcast(b); }
+	friend inline SimdFloat operator-(float a,SimdFloat b) { return broadcast(a) - b; }
+	friend inline SimdFloat operator*(SimdFloat a,float b) { return a * broadcast(b); }
+	friend inline SimdFloat operator*(float a,SimdFloat b) { return broadcast(a) * b; }
+	friend inline SimdFloat operator/(SimdFloat a,float b) { return a / broadcast(b); }
+	friend inline SimdFloat operator/(float a,SimdFloat b) { return broadcast(a) / b; }
+	static inline SimdFloat min(SimdFloat a,float b) { return min(a,broadcast(b)); }
+	static inline SimdFloat max(SimdFloat a,float b) { return max(a,broadcast(b)); }
+	static inline SimdFloat selectGreater(SimdFloat a,float b,SimdFloat x,SimdFloat y) { return selectGreater(a,broadcast(b),x,y); }
+	//runs a scalar function per lane, used for transcendentals
+	template<typename F> inline SimdFloat map(F f) const
+	{
+		float t[Lanes];
+		store(t);
+		for(int i = 0 ; i < Lanes;i++)
+			t[i] = f(t[i]);
+		return load(t);
+	}
+};
+
+//Holds as many doubles as SimdFloat has lanes
+//Needed where the scalar code mixes float and double precision
+struct SimdDouble
+{
+#if defined(OBXD_SIMD_AVX)
+	__m256d lo,hi;
+	static inline SimdDouble from(SimdFloat a)
+	{
+		SimdDouble r;
+		r.lo = _mm256_cvtps_pd(_mm256_castps256_ps128(a.v));
+		r.hi = _mm256_cvtps_pd(_mm256_extractf128_ps(a.v,1));
+		return r;
+	}
+	static inline SimdDouble broadcast(double x) { SimdDouble r; r.lo = r.hi = _mm256_set1_pd(x); return r; }
+	inline SimdFloat toFloat() const
+	{
+		SimdFloat r;
+		r.v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)),_mm256_cvtpd_ps(hi),1);
+		return r;
+	}
+	friend inline SimdDouble operator+(SimdDouble a,SimdDouble b) { a.lo = _mm256_add_pd(a.lo,b.lo); a.hi = _mm256_add_pd(a.hi,b.hi); return a; }
+	friend inline SimdDouble operator-(SimdDouble a,SimdDouble b) { a.lo = _mm256_sub_pd(a.lo,b.lo); a.hi = _mm256_sub_pd(a.hi,b.hi); return a; }
+	friend inline SimdDouble operator*(SimdDouble a,SimdDouble b) { a.lo = _mm256_mul_pd(a.lo,b.lo); a.hi = _mm256_mul_pd(a.hi,b.hi); return a; }
+#elif defined(OBXD_SIMD_SSE2)
+	__m128d lo,hi;
+	static inline SimdDouble from(SimdFloat a)
+	{
+		SimdDouble r;
+		r.lo = _mm_cvtps_pd(a.v);
+		r.hi = _mm_cvtps_pd(_mm_movehl_ps(a.v,a.v));
+		return r;
+	}
+	static inline SimdDouble broadcast(double x) { SimdDouble r; r.lo = r.hi = _mm_set1_pd(x); return r; }
+	inline SimdFloat toFloat() const
+	{
+		SimdFloat r;
+		r.v = _mm_movelh_ps(_mm_cvtpd_ps(lo),_mm_cvtpd_ps(hi));
+		return r;
+	}
+	friend inline SimdDouble operator+(SimdDouble a,SimdDouble b) { a.lo = _mm_add_pd(a.lo,b.lo); a.hi = _mm_add_pd(a.hi,b.hi); return a; }
+	friend inline SimdDouble operator-(SimdDouble a,SimdDouble b) { a.lo = _mm_sub_pd(a.lo,b.lo); a.hi = _mm_sub_pd(a.hi,b.hi); return a; }
+	friend inline SimdDouble operator*(SimdDouble a,SimdDouble b) { a.lo = _mm_mul_pd(a.lo,b.lo); a.hi = _mm_mul_pd(a.hi,b.hi); return a; }
+#else
+	double v[SimdFloat::Lanes];
+	static inline SimdDouble from(SimdFloat a) { SimdDouble r; for(int i = 0 ; i < SimdFloat::Lanes;i++) r.v[i] = a.v[i]; return r; }
+	static inline SimdDouble broadcast(double x) { SimdDouble r; for(int i = 0 ; i < SimdFloat::Lanes;i++) r.v[i] = x; return r; }
+	inline SimdFloat toFloat() const { SimdFloat r; for(int i = 0 ; i < SimdFloat::Lanes;i++) r.v[i] = (float)v[i]; return r; }
+	friend inline SimdDouble operator+(SimdDouble a,SimdDouble b) { for(int i = 0 ; i < SimdFloat::Lanes;i++) a.v[i]+=b.v[i]; return a; }
+	friend inline SimdDouble operator-(SimdDouble a,SimdDouble b) { for(int i = 0 ; i < SimdFloat::Lanes;i++) a.v[i]-=b.v[i]; return a; }
+	friend inline SimdDouble operator*(SimdDouble a,SimdDouble b) { for(int i = 0 ; i < SimdFloat::Lanes;i++) a.v[i]*=b.v[i]; return a; }
+#endif
+	friend inline SimdDouble operator+(SimdDouble a,double b) { return a + broadcast(b); }
+	friend inline SimdDouble operator*(SimdDouble a,double b) { return a * broadcast(b); }
+	friend inline SimdDouble operator*(double a,SimdDouble b) { return broadcast(a) * b; }
+};
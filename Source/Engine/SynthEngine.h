@@ -23,11 +23,14 @@
  */
 #pragma once
 
-#include "../PluginProcessor.h"
+//the engine only needs JUCE itself, so the test project can build it without the processor
+#include <JuceHeader.h>
 #include "ObxdVoice.h"
 #include "Motherboard.h"
 #include "Params.h"
 #include "ParamSmoother.h"
+#include "BeatClock.h"
+#include "QualityGovernor.h"
 
 class SynthEngine
 {
@@ -36,7 +39,38 @@ private:
 	ParamSmoother cutoffSmoother;
 	ParamSmoother pitchWheelSmoother;
 	ParamSmoother modWheelSmoother;
+	BeatClock beatClock;
 	float sampleRate;
+	//settings as requested, a quality tier above QUALITY_FULL runs the voices below them
+	int qualityTier;
+	bool oversampleRequested;
+	//0 until the voice count parameter arrives
+	int voiceCountRequested;
+	int pitchPrecisionRequested;
+	int prewarpRequested,prewarpIntervalRequested;
+	int controlIntervalRequested;
+	int cappedVoiceCount(int tier) const
+	{
+		return tier >= QUALITY_VOICE_CAP ? jmax(1,(voiceCountRequested+1)/2) : voiceCountRequested;
+	}
+	void applyPitchPrecision()
+	{
+		const int precision = qualityTier >= QUALITY_CHEAP_KERNELS ? PITCH_FAST : pitchPrecisionRequested;
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
+			synth.voices[i].osc.pitchPrecision = precision;
+	}
+	void applyFilterPrewarp()
+	{
+		const int precision = qualityTier >= QUALITY_CHEAP_KERNELS ? PREWARP_FAST : prewarpRequested;
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
+			synth.voices[i].flt.setPrewarp(precision,prewarpIntervalRequested);
+	}
+	void applyControlInterval()
+	{
+		const int interval = qualityTier >= QUALITY_CHEAP_KERNELS ? jmax(controlIntervalRequested,16) : controlIntervalRequested;
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
+			synth.voices[i].setControlInterval(interval);
+	}
 	//JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthEngine)
 public:
 	SynthEngine():
@@ -45,14 +79,23 @@ public:
 		pitchWheelSmoother(),
 		modWheelSmoother()
 	{
+		qualityTier = QUALITY_FULL;
+		oversampleRequested = false;
+		voiceCountRequested = 0;
+		pitchPrecisionRequested = PITCH_EXACT;
+		prewarpRequested = PREWARP_EXACT;
+		prewarpIntervalRequested = 1;
+		controlIntervalRequested = 1;
 	}
 	~SynthEngine()
 	{
 		//delete synth;
 	}
-	void setPlayHead(float bpm,float retrPos)
+	//host transport at the start of a block of numSamples
+	void setPlayHead(float bpm,double ppq,bool playing,int numSamples)
 	{
-		synth.mlfo.hostSyncRetrigger(bpm,retrPos);
+		const bool jumped = beatClock.update(bpm,ppq,playing,numSamples);
+		synth.mlfo.hostSync(beatClock.getBeat(),beatClock.getBeatsPerSecond(),jumped);
 	}
 	void setSampleRate(float sr)
 	{
@@ -60,16 +103,119 @@ public:
 		cutoffSmoother.setSampleRate(sr);
 		pitchWheelSmoother.setSampleRate(sr);
 		modWheelSmoother.setSampleRate(sr);
+		beatClock.setSampleRate(sr);
 		synth.setSampleRate(sr);
 	}
+	//not for the audio thread, all voice parameters have to be sent again afterwards
+	void setVoicePoolSize(int count)
+	{
+		synth.setVoicePoolSize(count);
+	}
+	int getVoicePoolSize() const
+	{
+		return synth.getVoicePoolSize();
+	}
+	//one of the PITCH_ tiers from AudioUtils.h
+	void setPitchPrecision(int precision)
+	{
+		pitchPrecisionRequested = precision;
+		applyPitchPrecision();
+	}
+	//one of the PREWARP_ tiers from AudioUtils.h, the filter coefficient is recomputed every interval samples
+	void setFilterPrewarp(int precision,int interval)
+	{
+		prewarpRequested = precision;
+		prewarpIntervalRequested = interval;
+		applyFilterPrewarp();
+	}
+	//modulation is computed every interval samples and ramped in between, 1 is audio rate
+	void setControlInterval(int interval)
+	{
+		controlIntervalRequested = interval;
+		applyControlInterval();
+	}
+	//one of the QUALITY_ tiers from QualityGovernor.h, QUALITY_FULL applies the settings as requested
+	void setQualityTier(int tier)
+	{
+		if(tier == qualityTier)
+			return;
+		const int was = qualityTier;
+		qualityTier = tier;
+		const bool over = oversampleRequested && tier < QUALITY_NO_OVERSAMPLING;
+		if(over != synth.Oversample)
+			synth.SetOversample(over);
+		//voices above the cap release and fade out instead of being cut off
+		if(voiceCountRequested > 0 && cappedVoiceCount(tier) != cappedVoiceCount(was))
+			synth.setVoiceLimit(cappedVoiceCount(tier));
+		if((tier >= QUALITY_CHEAP_KERNELS) != (was >= QUALITY_CHEAP_KERNELS))
+		{
+			applyPitchPrecision();
+			applyFilterPrewarp();
+			applyControlInterval();
+		}
+	}
+	int getQualityTier() const
+	{
+		return qualityTier;
+	}
+	//factor the oversampling switch turns on and one of the DECIMATOR_ types
+	void setOversampleFactor(int factor,int decimator)
+	{
+		synth.setOversampleFactor(factor,decimator);
+	}
+	void setRenderThreads(int count)
+	{
+		synth.setRenderThreads(count);
+	}
+	//brackets all processBlock calls of one host block
+	void beginBlock()
+	{
+		synth.beginBlock();
+	}
+	void endBlock()
+	{
+		synth.endBlock();
+	}
+	//economy mode puts releasing voices below this level to sleep, see Motherboard::setCullLevel
+	void setVoiceCullLevel(float db)
+	{
+		synth.setCullLevel(db);
+	}
+	const Motherboard::CullStats& getCullStats() const
+	{
+		return synth.cullStats;
+	}
+	void resetCullStats()
+	{
+		synth.resetCullStats();
+	}
 	void processSample(float *left,float *right)
 	{
-		processCutoffSmoothed(cutoffSmoother.smoothStep());
-		procPitchWheelSmoothed(pitchWheelSmoother.smoothStep());
-		procModWheelSmoothed(modWheelSmoother.smoothStep());
+		//settled smoothers already pushed their final value to the voices
+		if(!cutoffSmoother.isConverged())
+			processCutoffSmoothed(cutoffSmoother.smoothStep());
+		if(!pitchWheelSmoother.isConverged())
+			procPitchWheelSmoothed(pitchWheelSmoother.smoothStep());
+		if(!modWheelSmoother.isConverged())
+			procModWheelSmoothed(modWheelSmoother.smoothStep());
 
 		synth.processSample(left,right);
 	}
+	void processBlock(float *left,float *right,int numSamples)
+	{
+		while(numSamples > 0)
+		{
+			const int n = jmin(numSamples,(int)Motherboard::MAX_BLOCK_SIZE);
+			cutoffSmoother.smoothBlock(synth.cutoffs,n);
+			pitchWheelSmoother.smoothBlock(synth.pitchWheels,n);
+			modWheelSmoother.smoothBlock(synth.vibratoAmounts,n);
+			synth.vibratoAmount = synth.vibratoAmounts[n-1];
+			synth.processBlock(left,right,n);
+			left+=n;
+			right+=n;
+			numSamples-=n;
+		}
+	}
 	void allNotesOff()
 	{
 		for(int i = 0 ;  i < 128;i++)
@@ -80,7 +226,7 @@ public:
 	void allSoundOff()
 	{
 		allNotesOff();
-		for(int i = 0 ; i < Motherboard::MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 			{
 				synth.voices[i].ResetEnvelope();
 			}
@@ -117,21 +263,21 @@ public:
 		synth.economyMode = val>0.5;
 	}
 #define ForEachVoice(expr) \
-	for(int i = 0 ; i < synth.MAX_VOICES;i++) \
+	for(int i = 0 ; i < synth.getVoicePoolSize();i++) \
 		{\
 			synth.voices[i].expr;\
 		}\
 
 	void procAmpVelocityAmount(float val)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].vamp= val;
 		}
 	}
 	void procFltVelocityAmount(float val)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].vflt= val;
 		}
@@ -159,25 +305,26 @@ public:
 	}
 	inline void procPitchWheelSmoothed(float val)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].pitchWheel = val;
 		}
 	}
 	void setVoiceCount(float param)
 	{
-		synth.setVoiceCount(roundToInt((param*(synth.MAX_VOICES-1)) +1));
+		voiceCountRequested = roundToInt((param*(synth.getVoicePoolSize()-1)) +1);
+		synth.setVoiceCount(cappedVoiceCount(qualityTier));
 	}
 	void procPitchWheelAmount(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].pitchWheelAmt = param>0.5?12:2;
 		}
 	}
 	void procPitchWheelOsc2Only(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].pitchWheelOsc2Only = param>0.5;
 		}
@@ -188,28 +335,28 @@ public:
 	}
 	void processTune(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.tune = param*2-1;
 		}
 	}
 	void processLegatoMode(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].legatoMode = roundToInt(param*3 + 1) -1;
 		}
 	}
 	void processOctave(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.oct = (roundToInt(param*4) -2)*12;
 		}
 	}
 	void processFilterKeyFollow(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].fltKF = param;
 		}
@@ -217,7 +364,7 @@ public:
 	void processSelfOscPush(float param)
 	{
 		ForEachVoice(selfOscPush = param>0.5);
-		ForEachVoice(flt.selfOscPush = param>0.5);
+		ForEachVoice(flt.setSelfOscPush(param>0.5));
 	}
 	void processUnison(float param)
 	{
@@ -225,7 +372,7 @@ public:
 	}
 	void processPortamento(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].porta =logsc(1-param,0.14,250,150);
 		}
@@ -274,63 +421,63 @@ public:
 	}
 	void processLfoAmt1(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfoa1 = logsc(logsc(param,0,1,60),0,60,10);
 		}
 	}
 	void processLfoOsc1(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfoo1 = param>0.5;
 		}
 	}
 	void processLfoOsc2(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfoo2 = param>0.5;
 		}
 	}
 	void processLfoFilter(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfof = param>0.5;
 		}
 	}
 	void processLfoPw1(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfopw1 = param>0.5;
 		}
 	}
 	void processLfoPw2(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfopw2 = param>0.5;
 		}
 	}
 	void processLfoAmt2(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].lfoa2 = linsc(param,0,0.7);
 		}
 	}
 	void processDetune(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.totalDetune = logsc(param,0.001,0.90);
 		}
 	}
 	void processPulseWidth(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.pulseWidth = linsc(param,0.0,0.95);
 		}
@@ -357,77 +504,77 @@ public:
 	}
 	void processOsc2Xmod(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.xmod= param*24;
 		}
 	}
 	void processEnvelopeToPitch(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].envpitchmod= param*36;
 		}
 	}
 	void processOsc2HardSync(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			synth.voices[i].osc.hardSync = param>0.5;
+			synth.voices[i].osc.setHardSync(param>0.5);
 		}
 	}
 	void processOsc1Pitch(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.osc1p = (param * 48);
 		}
 	}
 	void processOsc2Pitch(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.osc2p = (param * 48);
 		}
 	}
 	void processPitchQuantization(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			synth.voices[i].osc.quantizeCw = param>0.5;
+			synth.voices[i].osc.setQuantize(param>0.5);
 		}
 	}
 	void processOsc1Mix(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.o1mx = param;
 		}
 	}
 	void processOsc2Mix(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.o2mx = param;
 		}
 	}
 	void processNoiseMix(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.nmx = logsc(param,0,1,35);
 		}
 	}
 	void processBrightness(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].setBrightness(  linsc(param,7000,26000));
 		}
 	}
 	void processOsc2Det(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].osc.osc2Det = logsc(param,0.001,0.6);
 		}
@@ -435,30 +582,30 @@ public:
 
 	void processOsc1Saw(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			synth.voices[i].osc.osc1Saw = param>0.5;
+			synth.voices[i].osc.setOsc1Saw(param>0.5);
 		}
 	}
 	void processOsc1Pulse(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			synth.voices[i].osc.osc1Pul = param>0.5;
+			synth.voices[i].osc.setOsc1Pulse(param>0.5);
 		}
 	}
 	void processOsc2Saw(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			synth.voices[i].osc.osc2Saw= param>0.5;
+			synth.voices[i].osc.setOsc2Saw(param>0.5);
 		}
 	}
 	void processOsc2Pulse(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			synth.voices[i].osc.osc2Pul= param>0.5;
+			synth.voices[i].osc.setOsc2Pulse(param>0.5);
 		}
 	}
 
@@ -477,30 +624,29 @@ public:
 	}
 	void processBandpassSw(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			//synth.voices[i].cutoff = logsc(param,60,19000,30);
-			synth.voices[i].flt.bandPassSw = param>0.5;
+			synth.voices[i].flt.setBandPass(param>0.5);
 		}
 	}
 	void processResonance(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].flt.setResonance(0.991-logsc(1-param,0,0.991,40));
 		}
 	}
 	void processFourPole(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
-			//synth.voices[i].flt ;
-			synth.voices[i].fourpole = param>0.5;
+			synth.voices[i].flt.setFourPole(param>0.5);
 		}
 	}
 	void processMultimode(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			//synth.voices[i].flt ;
 			synth.voices[i].flt.setMultimode(linsc(param,0,1));
@@ -508,88 +654,89 @@ public:
 	}
 	void processOversampling(float param)
 	{
-		synth.SetOversample(param>0.5);
+		oversampleRequested = param>0.5;
+		synth.SetOversample(oversampleRequested && qualityTier < QUALITY_NO_OVERSAMPLING);
 	}
 	void processFilterEnvelopeAmt(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].fenvamt = linsc(param,0,140);
 		}
 	}
 	void processLoudnessEnvelopeAttack(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].env.setAttack(logsc(param,4,60000,900));
 		}
 	}
 	void processLoudnessEnvelopeDecay(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].env.setDecay(logsc(param,4,60000,900));
 		}
 	}
 	void processLoudnessEnvelopeRelease(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].env.setRelease(logsc(param,8,60000,900));
 		}
 	}
 	void processLoudnessEnvelopeSustain(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].env.setSustain(param);
 		}
 	}
 	void processFilterEnvelopeAttack(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].fenv.setAttack(logsc(param,1,60000,900));
 		}
 	}
 	void processFilterEnvelopeDecay(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].fenv.setDecay(logsc(param,1,60000,900));
 		}
 	}
 	void processFilterEnvelopeRelease(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].fenv.setRelease(logsc(param,1,60000,900));
 		}
 	}
 	void processFilterEnvelopeSustain(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].fenv.setSustain(param);
 		}
 	}
 	void processEnvelopeDetune(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].setEnvDer(linsc(param,0.0,1));
 		}
 	}
 	void processFilterDetune(float param)
 	{
-for(int i = 0 ; i < synth.MAX_VOICES;i++)
+for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].FltDetAmt = linsc(param,0.0,18);
 		}
 	}
 	void processPortamentoDetune(float param)
 	{
-		for(int i = 0 ; i < synth.MAX_VOICES;i++)
+		for(int i = 0 ; i < synth.getVoicePoolSize();i++)
 		{
 			synth.voices[i].PortaDetuneAmt = linsc(param,0.0,0.75);
 		}
@@ -23,30 +23,25 @@
  */
 #pragma once
 #include "SynthEngine.h"
-#include "BlepData.h"
+#include "BlepTable.h"
 class TriangleOsc 
 {
 	DelayLine<Samples> del1;
 	bool fall;
-	float buffer1[Samples*2];
+	BlepBuffer buffer1;
 	const int hsam;
 	const int n;
-	float const * blepPTR;
-	float const * blampPTR;
+	BlepTable const * blepPTR;
+	BlepTable const * blampPTR;
 
-	int bP1,bP2;
 public:
 	TriangleOsc() : hsam(Samples)
 		, n(Samples*2)
 	{
 		//del1 =new DelayLine(hsam);
 		fall = false;
-		bP1=bP2=0;
-	//	buffer1= new float[n];
-		for(int i = 0 ; i < n ; i++)
-			buffer1[i]=0;
-		blepPTR = blep;
-		blampPTR = blamp;
+		blepPTR = &BlepTable::getBlep();
+		blampPTR = &BlepTable::getBlamp();
 	}
 	~TriangleOsc()
 	{
@@ -55,33 +50,33 @@ public:
 	}
 	inline void setDecimation()
 	{
-		blepPTR = blepd2;
-		blampPTR = blampd2;
+		blepPTR = &BlepTable::getBlepD2();
+		blampPTR = &BlepTable::getBlampD2();
 	}
 	inline void removeDecimation()
 	{
-		blepPTR = blep;
-		blampPTR = blamp;
+		blepPTR = &BlepTable::getBlep();
+		blampPTR = &BlepTable::getBlamp();
 	}
 	inline float aliasReduction()
 	{
-		return -getNextBlep(buffer1,bP1);
+		return -buffer1.next();
 	}
 	inline void processMaster(float x,float delta)
 	{
 		if(x >= 1.0)
 		{
 			x-=1.0;
-			mixInBlampCenter(buffer1,bP1,x/delta,-4*Samples*delta);
+			mixInBlampCenter(x/delta,-4*Samples*delta);
 		}
 		if(x >= 0.5 && x - delta < 0.5)
 		{
-			mixInBlampCenter(buffer1,bP1,(x-0.5)/delta,4*Samples*delta);
+			mixInBlampCenter((x-0.5)/delta,4*Samples*delta);
 		}
 		if(x >= 1.0)
 		{
 			x-=1.0;
-			mixInBlampCenter(buffer1,bP1,x/delta,-4*Samples*delta);
+			mixInBlampCenter(x/delta,-4*Samples*delta);
 		}
 	}
 	inline float getValue(float x)
@@ -102,7 +97,7 @@ public:
 			x-=1.0;
 			if(((!hardSyncReset)||(x/delta > hardSyncFrac)))//de morgan processed equation
 			{
-				mixInBlampCenter(buffer1,bP1,x/delta,-4*Samples*delta);
+				mixInBlampCenter(x/delta,-4*Samples*delta);
 			}
 			else
 			{
@@ -115,7 +110,7 @@ public:
 			float frac = (x - 0.5) / delta;
 			if(((!hardSyncReset)||(frac > hardSyncFrac)))//de morgan processed equation
 			{
-				mixInBlampCenter(buffer1,bP1,frac,4*Samples*delta);
+				mixInBlampCenter(frac,4*Samples*delta);
 			}
 		}
 		if(x >= 1.0 && hspass)
@@ -123,7 +118,7 @@ public:
 			x-=1.0;
 			if(((!hardSyncReset)||(x/delta > hardSyncFrac)))//de morgan processed equation
 			{
-				mixInBlampCenter(buffer1,bP1,x/delta,-4*Samples*delta);
+				mixInBlampCenter(x/delta,-4*Samples*delta);
 			}
 			else
 			{
@@ -137,47 +132,16 @@ public:
 			float trans = (x-fracMaster);
 			float mix = trans < 0.5 ? 2*trans-0.5 : 1.5-2*trans;
 			if(trans >0.5)
-				mixInBlampCenter(buffer1,bP1,hardSyncFrac,-4*Samples*delta);
-			mixInImpulseCenter(buffer1,bP1,hardSyncFrac,mix+0.5);
+				mixInBlampCenter(hardSyncFrac,-4*Samples*delta);
+			mixInImpulseCenter(hardSyncFrac,mix+0.5);
 		}
 	}
-	inline void mixInBlampCenter(float * buf,int& bpos,float offset, float scale)
+	inline void mixInBlampCenter(float offset, float scale)
 	{
-		int lpIn =(int)(B_OVERSAMPLING*(offset));
-		float frac = offset * B_OVERSAMPLING - lpIn;
-		float f1 = 1.0f-frac;
-		for(int i = 0 ; i < n;i++)
-		{
-			float mixvalue = (blampPTR[lpIn]*f1+blampPTR[lpIn+1]*(frac));
-			buf[(bpos+i)&(n-1)]  += mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
+		buffer1.mixIn(*blampPTR,offset,scale);
 	}
-		inline void mixInImpulseCenter(float * buf,int& bpos,float offset, float scale) 
+	inline void mixInImpulseCenter(float offset, float scale)
 	{
-		int lpIn =(int)(B_OVERSAMPLING*(offset));
-		float frac = offset * B_OVERSAMPLING - lpIn;
-		float f1 = 1.0f-frac;
-		for(int i = 0 ; i < Samples;i++)
-		{
-			float mixvalue = (blepPTR[lpIn]*f1+blepPTR[lpIn+1]*(frac));
-			buf[(bpos+i)&(n-1)]  += mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
-		for(int i = Samples ; i <n;i++)
-		{
-			float mixvalue = (blepPTR[lpIn]*f1+blepPTR[lpIn+1]*(frac));
-			buf[(bpos+i)&(n-1)]  -= mixvalue*scale;
-			lpIn += B_OVERSAMPLING;
-		}
-	}
-	inline float getNextBlep(float* buf,int& bpos) 
-	{
-		buf[bpos]= 0.0f;
-		bpos++;
-
-		// Wrap pos
-		bpos&=(n-1);
-		return buf[bpos];
+		buffer1.mixIn(*blepPTR,offset,scale);
 	}
 };
@@ -46,6 +46,17 @@ public:
 		idx %=total;
 		return &voices[idx];
 	}
+	//index of the voice handed out last
+	inline int getIndex() const
+	{
+		return idx;
+	}
+	//hands out a given voice, the queue continues after it
+	inline ObxdVoice* getAt(int i)
+	{
+		idx = i;
+		return &voices[idx];
+	}
 	inline void reInit(int voiceCount)
 	{
 		total = voiceCount;
@@ -93,7 +93,8 @@ public:
     
     void paintOverChildren (Graphics& g) override
 	{
-		int ofs = getSelectedId() - 1;
+		// skins only carry frames up to their own voice count
+		int ofs = jmin (getSelectedId() - 1, kni.getHeight() / h2 - 1);
         g.drawImage(kni, 0, 0, getWidth(), getHeight(), 0, h2 * ofs, w2, h2);
 	}
 
@@ -163,7 +163,7 @@ void ObxdAudioProcessorEditor::loadSkin(ObxdAudioProcessor& ownerFilter){
     // Prepare data
     if (voiceSwitch){
         
-        for (int i = 1; i <= 32; ++i)
+        for (int i = 1; i <= ownerFilter.getVoicePoolSize(); ++i)
         {
             voiceSwitch->addChoice (String (i));
         }
@@ -182,6 +182,7 @@ void ObxdAudioProcessorEditor::loadSkin(ObxdAudioProcessor& ownerFilter){
                                                                      ownerFilter.getEngineParameterId (LEGATOMODE),
                                                                      *legatoSwitch));
     
+    addQualityLabel();
     ownerFilter.addChangeListener (this);
     repaint();
 }
@@ -201,6 +202,26 @@ void ObxdAudioProcessorEditor::placeLabel (int x, int y, String text)
 	addAndMakeVisible (lab);
 }
 
+// only shown while the CPU governor holds quality below the settings, added last so it sits on top of the skin
+void ObxdAudioProcessorEditor::addQualityLabel()
+{
+	qualityLabel.setBounds (4, getHeight() - 18, 200, 14);
+	qualityLabel.setFont (Font (12.0f));
+	qualityLabel.setColour (Label::textColourId, Colours::red);
+	qualityLabel.setJustificationType (Justification::centredLeft);
+	qualityLabel.setInterceptsMouseClicks (false, false);
+	addChildComponent (qualityLabel);
+	updateQualityLabel();
+}
+
+void ObxdAudioProcessorEditor::updateQualityLabel()
+{
+	const int tier = processor.getQualityTier();
+	qualityLabel.setText ("CPU: " + String (QualityGovernor::getTierName (tier)), dontSendNotification);
+	qualityLabel.setVisible (tier != QUALITY_FULL);
+	qualityLabel.toFront (false);
+}
+
 ButtonList* ObxdAudioProcessorEditor::addList (int x, int y, int width, int height, ObxdAudioProcessor& filter, int parameter, String /*name*/, Image img)
 {
 	ButtonList *bl = new ButtonList (img, height);
@@ -279,6 +300,7 @@ void ObxdAudioProcessorEditor::rebuildComponents (ObxdAudioProcessor& ownerFilte
 
 		setSize (1440, 450);
 
+	addQualityLabel();
 	ownerFilter.addChangeListener (this);
 	repaint();
 }
@@ -408,6 +430,7 @@ void ObxdAudioProcessorEditor::changeListenerCallback (ChangeBroadcaster* source
     for (int i = 0; i < buttonListAttachments.size(); i++){
         buttonListAttachments[i]->updateToSlider();
     }
+    updateQualityLabel();
     repaint();
 }
 
@@ -44,6 +44,8 @@ public:
 private:
 	Knob* addKnob (int x, int y, int d, ObxdAudioProcessor& filter, int parameter, String name, float defval);
 	void placeLabel (int x, int y, String text);
+	void addQualityLabel();
+	void updateQualityLabel();
 	TooglableButton* addButton (int x, int y, int w, int h, ObxdAudioProcessor& filter, int parameter, String name);
 	ButtonList* addList(int x, int y, int w, int h, ObxdAudioProcessor& filter, int parameter, String name, Image img);
     void addMenu (int x, int y, int d, const Image&);
@@ -130,6 +132,7 @@ private:
     *legatoSwitch = nullptr;
 
 	File skinFolder;
+	Label qualityLabel;
     
     //==============================================================================
     OwnedArray<Knob::KnobAttachment>              knobAttachments;
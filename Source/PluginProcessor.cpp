@@ -28,10 +28,18 @@ It contains the basic startup code for a Juce application.
 #define S(T) (juce::String(T))
 
 //==============================================================================
+// reports the quality governor's tier to the host, only the processor sets it
+class ReadOnlyParameterInt : public AudioParameterInt
+{
+public:
+    using AudioParameterInt::AudioParameterInt;
+    bool isAutomatable() const override { return false; }
+};
+
 AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
 {
     ObxdParams defaultParams;
-    std::vector<std::unique_ptr<AudioParameterFloat>> params;
+    std::vector<std::unique_ptr<RangedAudioParameter>> params;
     
     for (int i = 0; i < PARAM_COUNT; ++i)
     {
@@ -46,6 +54,10 @@ AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
         
         params.push_back (std::move (parameter));
     }
+
+    // after the engine parameters so their indices stay the engine indices
+    params.push_back (std::make_unique<ReadOnlyParameterInt> ("qualityTier", TRANS ("Quality Tier"),
+                                                              QUALITY_FULL, QUALITY_TIER_COUNT - 1, QUALITY_FULL));
     
     return { params.begin(), params.end() };
 }
@@ -62,6 +74,15 @@ ObxdAudioProcessor::ObxdAudioProcessor()
 	lastMovedController = 0;
 	lastUsedParameter = 0;
 
+    // parameters are created in engine index order, so the processor's
+    // parameter index is the engine index
+    for (int i = 0; i < PARAM_COUNT; ++i)
+    {
+        engineParameters[i] = apvtState.getParameter (getEngineParameterId (i));
+        jassert (engineParameters[i]->getParameterIndex() == i);
+    }
+    qualityTierParameter = dynamic_cast<AudioParameterInt*> (apvtState.getParameter ("qualityTier"));
+
 	synth.setSampleRate (44100);
 
 	PropertiesFile::Options options;
@@ -71,6 +92,8 @@ ObxdAudioProcessor::ObxdAudioProcessor()
 	options.processLock = &configLock;
 	config = std::unique_ptr<PropertiesFile> (new PropertiesFile (getDocumentFolder().getChildFile ("Settings.xml"), options));
 
+	synth.setVoicePoolSize (config->getIntValue ("maxVoices", Motherboard::DEFAULT_VOICES));
+
 	currentSkin = config->containsKey("skin") ? config->getValue("skin") : "discoDSP Blue";
 	currentBank = "Init";
 
@@ -84,14 +107,24 @@ ObxdAudioProcessor::ObxdAudioProcessor()
     
     for (int i = 0; i < PARAM_COUNT; ++i)
     {
-        apvtState.addParameterListener (getEngineParameterId (i), this);
+        engineParameters[i]->addListener (this);
     }
     
     apvtState.state = ValueTree (JucePlugin_Name);
+
+    // the quality tier parameter is only touched on the message thread
+    startTimer (250);
 }
 
 ObxdAudioProcessor::~ObxdAudioProcessor()
 {
+    stopTimer();
+
+    for (int i = 0; i < PARAM_COUNT; ++i)
+    {
+        engineParameters[i]->removeListener (this);
+    }
+
 	config->saveIfNeeded();
 	config = nullptr;
 }
@@ -194,97 +227,136 @@ void ObxdAudioProcessor::prepareToPlay (double sampleRate, int /*samplesPerBlock
 {
 	// Use this method as the place to do any pre-playback
 	// initialisation that you need..
-	nextMidi = new MidiMessage (0xF0);
-	midiMsg  = new MidiMessage (0xF0);
 	synth.setSampleRate (sampleRate);
+
+	// the pool is only reallocated here and in the constructor, never on the audio thread
+	const int poolSize = synth.getVoicePoolSize();
+	synth.setVoicePoolSize (config->getIntValue ("maxVoices", Motherboard::DEFAULT_VOICES));
+	if (synth.getVoicePoolSize() != poolSize)
+		parametersNeedResync = true;
+
+	// exp approximation tier for oscillator and cutoff pitch, exact unless set in Settings.xml
+	synth.setPitchPrecision (config->getIntValue ("pitchPrecision", PITCH_EXACT));
+
+	// filter cutoff prewarp tier and coefficient update interval, exact and per sample by default
+	synth.setFilterPrewarp (config->getIntValue ("filterPrecision", PREWARP_EXACT),
+							config->getIntValue ("filterCoefInterval", 1));
+
+	// control rate modulation, 8, 16 or 32 trade accuracy for CPU, audio rate by default
+	synth.setControlInterval (config->getIntValue ("controlInterval", 1));
+
+	// oversampling factor of the HQ switch, 2, 4 or 8, and the decimator, 17 tap FIR unless set
+	// settings from before the decimator key only had the cheapDecimation switch
+	const int decimator = config->containsKey ("decimator")
+		? config->getIntValue ("decimator")
+		: (config->getBoolValue ("cheapDecimation", false) ? DECIMATOR_FIR_CHEAP : DECIMATOR_FIR);
+	synth.setOversampleFactor (config->getIntValue ("oversampling", 2), decimator);
+
+	// optional voice rendering on extra threads, off unless set in Settings.xml
+	synth.setRenderThreads (config->getIntValue ("renderThreads", 0));
+
+	// the lowest QUALITY_ tier the CPU governor may step down to, off unless set in Settings.xml
+	governor.setSampleRate (sampleRate);
+	governor.setMaxTier (config->getIntValue ("cpuGovernor", QUALITY_FULL));
+	synth.setQualityTier (governor.getTier());
+	qualityTier = governor.getTier();
+
+	// releasing voices quieter than this many dB below full scale are put to sleep, 0 turns it off
+	synth.setVoiceCullLevel ((float) config->getDoubleValue ("voiceCullLevel", -90.0));
+	synth.resetCullStats();
+	applyPendingParameters (std::numeric_limits<int>::max());
 }
 
 void ObxdAudioProcessor::releaseResources()
 {
+	const Motherboard::CullStats& stats = synth.getCullStats();
+	DBG ("economy mode: " << stats.culledVoices << " voices culled, "
+		 << stats.savedSamples << " of " << (stats.renderedSamples + stats.savedSamples) << " voice samples saved");
 }
 
-inline void ObxdAudioProcessor::processMidiPerSample (MidiBuffer::Iterator* iter, const int samplePos)
+void ObxdAudioProcessor::processMidiEvent (const uint8* data, const int numBytes, const int samplePos)
 {
-	while (getNextEvent (iter, samplePos))
+	// works on the raw bytes so no MidiMessage gets copied on the audio thread
+	if (numBytes < 1 || data[0] < 0x80 || data[0] >= 0xF0)
+		return;
+
+	// program change and channel pressure carry one data byte, the other channel messages two
+	const int status = data[0] & 0xF0;
+	const int length = (status == 0xC0 || status == 0xD0) ? 2 : 3;
+	if (numBytes < length)
+		return;
+
+	const int data1 = data[1];
+	const int data2 = length == 3 ? data[2] : 0;
+
+	if (status == 0x90 && data2 > 0)
 	{
-		if (midiMsg->isNoteOn())
-		{
-			synth.procNoteOn (midiMsg->getNoteNumber(), midiMsg->getFloatVelocity());
-		}
-		if (midiMsg->isNoteOff())
-		{
-			synth.procNoteOff (midiMsg->getNoteNumber());
-		}
-		if (midiMsg->isPitchWheel())
-		{
-			// [0..16383] center = 8192;
-			synth.procPitchWheel ((midiMsg->getPitchWheelValue() - 8192) / 8192.0f);
-		}
-		if (midiMsg->isController() && midiMsg->getControllerNumber() == 1)
-        {
-			synth.procModWheel (midiMsg->getControllerValue() / 127.0f);
-        }
-		if (midiMsg->isController())
-		{
-			lastMovedController = midiMsg->getControllerNumber();
-            
-			if (programs.currentProgramPtr->values[MIDILEARN] > 0.5f)
-				bindings.controllers[lastMovedController] = lastUsedParameter;
-            
-			if (programs.currentProgramPtr->values[UNLEARN] > 0.5f)
-			{
-				midiControlledParamSet = true;
-				bindings.controllers[lastMovedController] = 0;
-				setEngineParameterValue (UNLEARN, 0);
-				lastMovedController = 0;
-				lastUsedParameter = 0;
-				midiControlledParamSet = false;
-			}
+		synth.procNoteOn (data1, data2 * (1.0f / 127.0f));
+	}
+	if (status == 0x80 || (status == 0x90 && data2 == 0))
+	{
+		synth.procNoteOff (data1);
+	}
+	if (status == 0xE0)
+	{
+		// [0..16383] center = 8192;
+		synth.procPitchWheel (((data1 | (data2 << 7)) - 8192) / 8192.0f);
+	}
+	if (status != 0xB0)
+		return;
 
-			if (bindings.controllers[lastMovedController] > 0)
-			{
-				midiControlledParamSet = true;
-				setEngineParameterValue (bindings.controllers[lastMovedController],
-                                         midiMsg->getControllerValue() / 127.0f);
-                
-				setEngineParameterValue (MIDILEARN, 0);
-				lastMovedController = 0;
-				lastUsedParameter = 0;
-
-				midiControlledParamSet = false;
-			}
+	if (data1 == 1)
+	{
+		synth.procModWheel (data2 / 127.0f);
+	}
 
-		}
-		if(midiMsg->isSustainPedalOn())
-		{
-			synth.sustainOn();
-		}
-		if(midiMsg->isSustainPedalOff() || midiMsg->isAllNotesOff()||midiMsg->isAllSoundOff())
-		{
-			synth.sustainOff();
-		}
-		if(midiMsg->isAllNotesOff())
-		{
-			synth.allNotesOff();
-		}
-		if(midiMsg->isAllSoundOff())
-		{
-			synth.allSoundOff();
-		}
+	lastMovedController = data1;
 
+	if (programs.currentProgramPtr->values[MIDILEARN] > 0.5f)
+		bindings.controllers[lastMovedController] = lastUsedParameter;
+
+	if (programs.currentProgramPtr->values[UNLEARN] > 0.5f)
+	{
+		midiControlledParamSet = true;
+		bindings.controllers[lastMovedController] = 0;
+		setEngineParameterValue (UNLEARN, 0);
+		lastMovedController = 0;
+		lastUsedParameter = 0;
+		midiControlledParamSet = false;
 	}
-}
 
-bool ObxdAudioProcessor::getNextEvent (MidiBuffer::Iterator* iter, const int samplePos)
-{
-	if (hasMidiMessage && midiEventPos <= samplePos)
+	if (bindings.controllers[lastMovedController] > 0)
 	{
-		*midiMsg = *nextMidi;
-		hasMidiMessage = iter->getNextEvent (*nextMidi, midiEventPos);
-		return true;
+		midiControlledParamSet = true;
+		setEngineParameterValue (bindings.controllers[lastMovedController],
+                                 data2 / 127.0f, samplePos);
+
+		setEngineParameterValue (MIDILEARN, 0);
+		lastMovedController = 0;
+		lastUsedParameter = 0;
+
+		midiControlledParamSet = false;
+	}
+
+	const bool allNotesOff = data1 == 123;
+	const bool allSoundOff = data1 == 120;
+
+	if (data1 == 64 && data2 >= 64)
+	{
+		synth.sustainOn();
+	}
+	if ((data1 == 64 && data2 < 64) || allNotesOff || allSoundOff)
+	{
+		synth.sustainOff();
+	}
+	if (allNotesOff)
+	{
+		synth.allNotesOff();
+	}
+	if (allSoundOff)
+	{
+		synth.allSoundOff();
 	}
-    
-	return false;
 }
 
 void ObxdAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
@@ -296,9 +368,13 @@ void ObxdAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& mi
 #ifdef __SSE2__
 	// _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
 #endif
+	const int64 startTicks = Time::getHighResolutionTicks();
 
 	MidiBuffer::Iterator ppp (midiMessages);
-	hasMidiMessage = ppp.getNextEvent (*nextMidi, midiEventPos);
+	const uint8* midiData = nullptr;
+	int midiBytes = 0;
+	int midiEventPos = 0;
+	bool hasMidiMessage = ppp.getNextEvent (midiData, midiBytes, midiEventPos);
 
 	int samplePos = 0;
 	int numSamples = buffer.getNumSamples();
@@ -309,14 +385,37 @@ void ObxdAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& mi
     
     if (getPlayHead() != 0 && getPlayHead()->getCurrentPosition (pos))
     {
-		synth.setPlayHead(pos.bpm, pos.ppqPosition);
+		synth.setPlayHead(pos.bpm, pos.ppqPosition, pos.isPlaying, numSamples);
     }
 
+	synth.beginBlock();
+
+	// the block is split at event timestamps, events are dispatched between the spans
 	while (samplePos < numSamples)
 	{
-		processMidiPerSample (&ppp, samplePos);
-		synth.processSample (channelData1+samplePos, channelData2+samplePos);
-		++samplePos;
+		while (hasMidiMessage && midiEventPos <= samplePos)
+		{
+			processMidiEvent (midiData, midiBytes, midiEventPos);
+			hasMidiMessage = ppp.getNextEvent (midiData, midiBytes, midiEventPos);
+		}
+
+		applyPendingParameters (samplePos);
+
+		const int spanEnd = hasMidiMessage ? jmin (midiEventPos, numSamples) : numSamples;
+		synth.processBlock (channelData1 + samplePos, channelData2 + samplePos, spanEnd - samplePos);
+		samplePos = spanEnd;
+	}
+	synth.endBlock();
+
+	// trades quality for time when blocks come close to their real time budget, offline renders keep full quality
+	if (! isNonRealtime())
+	{
+		const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+		if (governor.update (seconds, numSamples))
+		{
+			synth.setQualityTier (governor.getTier());
+			qualityTier = governor.getTier();
+		}
 	}
 }
 
@@ -342,7 +441,7 @@ void ObxdAudioProcessor::getStateInformation(MemoryBlock& destData)
 	{
 		XmlElement* xpr = new XmlElement("program");
 		xpr->setAttribute(S("programName"), programs.programs[i].name);
-		xpr->setAttribute(S("voiceCount"), Motherboard::MAX_VOICES);
+		xpr->setAttribute(S("voiceCount"), synth.getVoicePoolSize());
 
 		for (int k = 0; k < PARAM_COUNT; ++k)
 		{
@@ -371,7 +470,7 @@ void ObxdAudioProcessor::getCurrentProgramStateInformation(MemoryBlock& destData
 		xmlState.setAttribute(String(k), programs.currentProgramPtr->values[k]);
 	}
 
-	xmlState.setAttribute(S("voiceCount"), Motherboard::MAX_VOICES);
+	xmlState.setAttribute(S("voiceCount"), synth.getVoicePoolSize());
 	xmlState.setAttribute(S("programName"), programs.currentProgramPtr->name);
 
 	copyXmlToBinary(xmlState, destData);
@@ -399,6 +498,7 @@ void ObxdAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 				{
 					float value = float(e->getDoubleAttribute(String(k), programs.programs[i].values[k]));
 					if (!newFormat && k == VOICE_COUNT) value *= 0.25f;
+					if (newFormat && k == VOICE_COUNT) value = rescaleVoiceCount(value, e->getIntAttribute("voiceCount"));
 					programs.programs[i].values[k] = value;
 				}
 
@@ -438,6 +538,7 @@ void  ObxdAudioProcessor::setCurrentProgramStateInformation(const void* data, in
 		{
 			float value = float(e->getDoubleAttribute(String(k), programs.currentProgramPtr->values[k]));
 			if (!newFormat && k == VOICE_COUNT) value *= 0.25f;
+			if (newFormat && k == VOICE_COUNT) value = rescaleVoiceCount(value, e->getIntAttribute("voiceCount"));
 			programs.currentProgramPtr->values[k] = value;
 		}
 
@@ -452,6 +553,17 @@ void  ObxdAudioProcessor::setCurrentProgramStateInformation(const void* data, in
 	}
 }
 
+float ObxdAudioProcessor::rescaleVoiceCount(float value, int savedPoolSize) const
+{
+	// keeps the number of voices when the state was saved with another pool size
+	const int poolSize = synth.getVoicePoolSize();
+	if (savedPoolSize == poolSize || savedPoolSize < 2 || poolSize < 2)
+		return value;
+
+	const int voices = jlimit(1, poolSize, roundToInt(value * (savedPoolSize - 1)) + 1);
+	return (voices - 1) / float(poolSize - 1);
+}
+
 //==============================================================================
 bool ObxdAudioProcessor::loadFromFXBFile(const File& fxbFile)
 {
@@ -721,30 +833,47 @@ String ObxdAudioProcessor::getEngineParameterId (size_t index)
     return "Undefined";
 }
 
-int ObxdAudioProcessor::getParameterIndexFromId (String paramId)
+void ObxdAudioProcessor::setEngineParameterValue (int index, float newValue, int sampleOffset)
 {
-    for (size_t i = 0; i < PARAM_COUNT; ++i)
+    if (! midiControlledParamSet || index == MIDILEARN || index == UNLEARN)
     {
-        if (paramId.compare (getEngineParameterId (i)) == 0)
-        {
-            return int (i);
-        }
+        lastUsedParameter = index;
     }
     
-    return -1;
+    programs.currentProgramPtr->values[index] = newValue;
+    engineParameters[index]->setValue (newValue);
+
+    // the engine is only touched by the audio thread, which drains this queue
+    if (! parameterQueue.push (index, newValue, sampleOffset))
+        parametersNeedResync = true;
+    
+    //DIRTY HACK
+    //This should be checked to avoid stalling on gui update
+    //It is needed because some hosts do  wierd stuff
+    if (isHostAutomatedChange)
+        sendChangeMessage();
 }
 
-void ObxdAudioProcessor::setEngineParameterValue (int index, float newValue)
+void ObxdAudioProcessor::applyPendingParameters (int samplePos)
 {
-    if (! midiControlledParamSet || index == MIDILEARN || index == UNLEARN)
+    ParamQueue::Entry entry;
+
+    while (parameterQueue.peek (entry) && entry.sampleOffset <= samplePos)
     {
-        lastUsedParameter = index;
+        applyEngineParameter (entry.index, entry.value);
+        parameterQueue.pop();
     }
-    
-    programs.currentProgramPtr->values[index] = newValue;
-    apvtState.getParameter(getEngineParameterId(index))->setValue(newValue);
-    
-    
+
+    // the queue overflowed, so bring everything in line with the current program
+    if (parametersNeedResync.exchange (false))
+    {
+        for (int i = 0; i < PARAM_COUNT; ++i)
+            applyEngineParameter (i, programs.currentProgramPtr->values[i]);
+    }
+}
+
+void ObxdAudioProcessor::applyEngineParameter (int index, float newValue)
+{
     switch (index)
     {
         case SELF_OSC_PUSH:
@@ -979,22 +1108,29 @@ void ObxdAudioProcessor::setEngineParameterValue (int index, float newValue)
             synth.processPan (newValue,8);
             break;
     }
-    
-    //DIRTY HACK
-    //This should be checked to avoid stalling on gui update
-    //It is needed because some hosts do  wierd stuff
-    if (isHostAutomatedChange)
-        sendChangeMessage();
 }
 
 //==============================================================================
-void ObxdAudioProcessor::parameterChanged (const String& parameter, float newValue)
+void ObxdAudioProcessor::parameterValueChanged (int parameterIndex, float newValue)
 {
-    int index = getParameterIndexFromId (parameter);
-    
-    if ( isPositiveAndBelow (index, PARAM_COUNT) )
+    if ( isPositiveAndBelow (parameterIndex, PARAM_COUNT) )
+    {
+        setEngineParameterValue (parameterIndex, newValue);
+    }
+}
+
+void ObxdAudioProcessor::parameterGestureChanged (int, bool)
+{
+}
+
+void ObxdAudioProcessor::timerCallback()
+{
+    // the governor runs on the audio thread, the host and the editor hear about its tier from here
+    const int tier = qualityTier.load();
+    if (qualityTierParameter->get() != tier)
     {
-        setEngineParameterValue (index, newValue);
+        *qualityTierParameter = tier;
+        sendChangeMessage();
     }
 }
 
@@ -30,6 +30,7 @@
 //#include <stack>
 #include "Engine/midiMap.h"
 #include "Engine/ObxdBank.h"
+#include "Engine/ParamQueue.h"
 
 //==============================================================================
 const int fxbVersionNum = 1;
@@ -114,8 +115,9 @@ static inline float fxbSwapFloat (const float x) noexcept
 /**
 */
 class ObxdAudioProcessor  : public AudioProcessor,
-	                        public AudioProcessorValueTreeState::Listener,
-	                        public ChangeBroadcaster
+	                        public AudioProcessorParameter::Listener,
+	                        public ChangeBroadcaster,
+	                        private Timer
 {
 public:
     //==============================================================================
@@ -133,8 +135,7 @@ public:
     bool hasEditor() const override;
 	
 	//==============================================================================
-	void processMidiPerSample (MidiBuffer::Iterator* iter, const int samplePos);
-	bool getNextEvent (MidiBuffer::Iterator* iter, const int samplePos);
+	void processMidiEvent (const uint8* data, const int numBytes, const int samplePos);
 
 	//==============================================================================
     void initAllParams();
@@ -181,30 +182,40 @@ public:
 	void setCurrentSkinFolder(const String& folderName);
     
     //==============================================================================
+    int getVoicePoolSize() const { return synth.getVoicePoolSize(); }
+    int getQualityTier() const { return qualityTier.load(); }
+    float rescaleVoiceCount (float value, int savedPoolSize) const;
+
     static String getEngineParameterId (size_t);
-    int getParameterIndexFromId (String);
-    void setEngineParameterValue (int, float);
-    void parameterChanged (const String&, float) override;
+    void setEngineParameterValue (int, float, int sampleOffset = 0);
+    void parameterValueChanged (int, float) override;
+    void parameterGestureChanged (int, bool) override;
     AudioProcessorValueTreeState& getPluginState();
 
 private:
+	//==============================================================================
+	void applyPendingParameters (int samplePos);
+	void applyEngineParameter (int, float);
+	void timerCallback() override;
+
 	//==============================================================================
 	bool isHostAutomatedChange;
 
 	int lastMovedController;
 	int lastUsedParameter;
 
-	MidiMessage* nextMidi;
-	MidiMessage* midiMsg;
 	MidiMap bindings;
 	bool midiControlledParamSet;
 
-	bool hasMidiMessage;
-	int midiEventPos;
-
 	SynthEngine synth;
+	QualityGovernor governor;
+	// the governor's tier as last set on the audio thread, published to the host by the timer
+	std::atomic<int> qualityTier { QUALITY_FULL };
 	ObxdBank programs;
 
+	ParamQueue parameterQueue;
+	std::atomic<bool> parametersNeedResync { false };
+
 	String currentSkin;
 	String currentBank;
 	Array<File> bankFiles;
@@ -216,6 +227,10 @@ private:
     AudioProcessorValueTreeState apvtState;
     UndoManager                  undoManager;
 
+    // engine index -> parameter, filled once so the audio thread never looks up ids
+    RangedAudioParameter* engineParameters[PARAM_COUNT];
+    AudioParameterInt* qualityTierParameter;
+
 	//==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ObxdAudioProcessor)
 };
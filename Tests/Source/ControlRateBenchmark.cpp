@@ -0,0 +1,155 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+#include "../../Source/Engine/SynthEngine.h"
+
+//==============================================================================
+// Render time of the control rate intervals on a full engine, and how far
+// cutoff and amp modulation of one voice move away from the audio rate path
+class ControlRateBenchmark : public UnitTest
+{
+public:
+    ControlRateBenchmark() : UnitTest ("Control rate", "Benchmarks") {}
+
+    void runTest() override
+    {
+        const int intervals[] = { 1, 8, 16, 32 };
+
+        beginTest ("Render time, 10 s of 32 voices");
+        for (int interval : intervals)
+            for (int economy = 1; economy >= 0; --economy)
+                logMessage ("interval " + String (interval) + (economy ? ", economy " : ", all voices ")
+                            + String (renderMs (interval, economy != 0), 1) + " ms");
+
+        beginTest ("Modulation error against audio rate");
+        std::vector<float> cutRef, ampRef;
+        renderVoice (1, cutRef, ampRef);
+        for (int interval : intervals)
+        {
+            if (interval == 1)
+                continue;
+            std::vector<float> cut, amp;
+            renderVoice (interval, cut, amp);
+            // skips the ramp from zero up to the first tick
+            double cents = 0, ampError = 0;
+            for (size_t i = (size_t) interval + 64; i < cut.size(); ++i)
+            {
+                cents = jmax (cents, std::abs (1200.0 * std::log2 (cut[i] / cutRef[i])));
+                ampError = jmax (ampError, (double) std::abs (amp[i] - ampRef[i]));
+            }
+            expect (std::isfinite (cents) && std::isfinite (ampError));
+            logMessage ("interval " + String (interval) + ", cutoff " + String (cents, 1) + " cent, amp " + String (ampError, 4));
+        }
+    }
+
+private:
+    // a chord of 32 notes struck every second, block path
+    static double renderMs (int interval, bool economy)
+    {
+        const int sampleRate = 44100, block = 256;
+        std::unique_ptr<SynthEngine> synth (new SynthEngine());
+        synth->setSampleRate (sampleRate);
+        synth->setVoiceCount (1.0f);
+        synth->procEconomyMode (economy ? 1.0f : 0.0f);
+        synth->processOsc1Saw (1);
+        synth->processOsc2Saw (1);
+        synth->processOsc1Mix (1);
+        synth->processOsc2Mix (1);
+        synth->processFilterEnvelopeAmt (0.4f);
+        synth->processFilterEnvelopeDecay (0.3f);
+        synth->processLoudnessEnvelopeRelease (0.3f);
+        synth->processLfoSine (1);
+        synth->processLfoFilter (1);
+        synth->processLfoAmt1 (0.2f);
+        synth->processPortamento (0.3f);
+        synth->setControlInterval (interval);
+
+        float left[block], right[block];
+        const int64 start = Time::getHighResolutionTicks();
+        for (int pos = 0; pos < 10 * sampleRate; pos += block)
+        {
+            // struck at each second and released half a second later, so attacks,
+            // releases and glides are rendered along with the sustain
+            const int half = sampleRate / 2;
+            if (pos == 0 || pos / sampleRate != (pos + block) / sampleRate)
+                for (int k = 0; k < 32; ++k)
+                    synth->procNoteOn (36 + k, 0.8f);
+            else if (pos / half != (pos + block) / half)
+                for (int k = 0; k < 32; ++k)
+                    synth->procNoteOff (36 + k);
+            synth->processBlock (left, right, block);
+        }
+        return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1000;
+    }
+
+    static float lfo (int i)
+    {
+        return std::sin (i * 2 * float_Pi * 5 / 44100);
+    }
+
+    // one voice with a 4 ms glide and a 2 ms filter attack, cutoff in Hz and amp envelope per sample
+    static void renderVoice (int interval, std::vector<float>& cut, std::vector<float>& amp)
+    {
+        const int n = 44100;
+        std::unique_ptr<ObxdVoice> voice (new ObxdVoice());
+        ObxdVoice& v = *voice;
+        v.setSampleRate (44100);
+        v.setControlInterval (interval);
+        v.fenvamt = 40;
+        v.cutoff = 20;
+        v.fltKF = 0.5f;
+        v.porta = 40;
+        v.lfof = true;
+        v.lfoa1 = 6;
+        v.lfoo2 = true;
+        v.env.setAttack (5);
+        v.env.setDecay (300);
+        v.env.setSustain (0.6f);
+        v.env.setRelease (200);
+        v.fenv.setAttack (2);
+        v.fenv.setDecay (150);
+        v.fenv.setSustain (0.2f);
+        v.fenv.setRelease (300);
+        v.NoteOn (60, 1);
+
+        cut.resize (n);
+        amp.resize (n);
+        for (int i = 0; i < n; ++i)
+        {
+            if (i == n / 3)
+                v.NoteOn (72, 1);
+            if (i == 2 * n / 3)
+                v.NoteOff();
+            // the filter reads the lfo through the voice's delay line
+            v.lfoIn = lfo (i);
+            v.lfoDelayedIn = lfo (i - ObxdVoice::LFO_DELAY);
+            float cutoffIndex, cutoffNoise, env;
+            v.processPreFilter (cutoffIndex, cutoffNoise, env);
+            cut[i] = v.cutoffFromIndex (cutoffIndex);
+            amp[i] = env;
+        }
+    }
+};
+
+static ControlRateBenchmark controlRateBenchmark;
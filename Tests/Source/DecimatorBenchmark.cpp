@@ -0,0 +1,112 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+#include "../../Source/Engine/SynthEngine.h"
+#include "ReferenceDecimators.h"
+
+//==============================================================================
+// Time per stereo output sample of each decimator type at each oversampling factor,
+// 64 sample output blocks as the engine runs them, next to the per sample reference
+class DecimatorBenchmark : public UnitTest
+{
+public:
+    DecimatorBenchmark() : UnitTest ("Decimators", "Benchmarks") {}
+
+    void runTest() override
+    {
+        const char* names[] = { "FIR", "cheap FIR", "IIR" };
+        const int types[] = { DECIMATOR_FIR, DECIMATOR_FIR_CHEAP, DECIMATOR_IIR };
+
+        beginTest ("ns per stereo output sample");
+        for (int factor = 2; factor <= DecimatorChain::MAX_FACTOR; factor *= 2)
+        {
+            for (int cheap = 0; cheap <= 1; ++cheap)
+                logMessage (String (factor) + "x reference " + names[cheap] + " "
+                            + String (referenceNs (factor, cheap != 0), 2) + " ns");
+
+            for (int type : types)
+                logMessage (String (factor) + "x " + names[type] + " "
+                            + String (chainNs (factor, type), 2) + " ns");
+        }
+    }
+
+private:
+    static const int block = 64;
+    static const int blocks = 100000;
+
+    static std::vector<float> noise (int factor)
+    {
+        std::vector<float> source (block * factor);
+        Random random (factor);
+        for (float& x : source)
+            x = random.nextFloat() - 0.5f;
+        return source;
+    }
+
+    double chainNs (int factor, int type)
+    {
+        const std::vector<float> source (noise (factor));
+        std::vector<float> l (source.size()), r (source.size());
+        DecimatorChain decimator;
+        decimator.setFactor (factor, type);
+        float sum = 0;
+        const int64 start = Time::getHighResolutionTicks();
+        for (int b = 0; b < blocks; ++b)
+        {
+            std::copy (source.begin(), source.end(), l.begin());
+            std::copy (source.begin(), source.end(), r.begin());
+            decimator.process (l.data(), r.data(), block);
+            sum += l[b & (block - 1)] + r[b & (block - 1)];
+        }
+        const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+        expect (std::isfinite (sum));
+        return seconds * 1e9 / ((double) blocks * block);
+    }
+
+    // the same copies as chainNs, then one calc per channel and output sample
+    double referenceNs (int factor, bool cheap)
+    {
+        const std::vector<float> source (noise (factor));
+        std::vector<float> l (source.size()), r (source.size());
+        ReferenceDecimatorChain left (factor, cheap), right (factor, cheap);
+        float sum = 0;
+        const int64 start = Time::getHighResolutionTicks();
+        for (int b = 0; b < blocks; ++b)
+        {
+            std::copy (source.begin(), source.end(), l.begin());
+            std::copy (source.begin(), source.end(), r.begin());
+            for (int i = 0; i < block; ++i)
+            {
+                l[i] = left.calc (l.data() + i * factor);
+                r[i] = right.calc (r.data() + i * factor);
+            }
+            sum += l[b & (block - 1)] + r[b & (block - 1)];
+        }
+        const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+        expect (std::isfinite (sum));
+        return seconds * 1e9 / ((double) blocks * block);
+    }
+};
+
+static DecimatorBenchmark decimatorBenchmark;
@@ -0,0 +1,132 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+#include "../../Source/Engine/SynthEngine.h"
+#include "ReferenceDecimators.h"
+
+//==============================================================================
+// The FIR chains against the per sample decimators they replaced, and the
+// passband and stopband of the IIR chain on sine sweeps
+class DecimatorTests : public UnitTest
+{
+public:
+    DecimatorTests() : UnitTest ("Decimators", "Engine") {}
+
+    void runTest() override
+    {
+        for (int factor = 2; factor <= DecimatorChain::MAX_FACTOR; factor *= 2)
+        {
+            beginTest ("FIR matches the reference, " + String (factor) + "x");
+            expectEquals (countMismatches (factor, DECIMATOR_FIR), 0);
+
+            beginTest ("Cheap FIR matches the reference, " + String (factor) + "x");
+            expectEquals (countMismatches (factor, DECIMATOR_FIR_CHEAP), 0);
+        }
+
+        for (int factor = 2; factor <= DecimatorChain::MAX_FACTOR; factor *= 2)
+        {
+            beginTest ("IIR response, " + String (factor) + "x");
+
+            // up to 0.45 of the output rate, 19.8 kHz at 44.1 kHz
+            double ripple = 0;
+            for (int bin = binStep; bin <= (int) (0.45 * window); bin += binStep)
+                ripple = jmax (ripple, std::abs (iirGainDb (factor, bin)));
+            expectLessOrEqual (ripple, 0.01);
+
+            // everything that folds back from above 0.52 of the output rate
+            double stopband = -1000;
+            for (int bin = (int) (0.52 * window); bin < factor * window / 2; bin += binStep)
+                stopband = jmax (stopband, iirGainDb (factor, bin));
+            expectLessOrEqual (stopband, -69.0);
+
+            logMessage ("passband ripple " + String (ripple, 4) + " dB, stopband " + String (stopband, 1) + " dB");
+        }
+    }
+
+private:
+    // output samples the response is measured over, sines sit on whole cycles of it
+    static const int window = 4096;
+    static const int binStep = 41;
+
+    // noise through the chain in blocks of varying length, against the reference per sample
+    static int countMismatches (int factor, int type)
+    {
+        const int blockSizes[] = { 64, 1, 17, 64, 63, 5, 64, 33 };
+        DecimatorChain chain;
+        chain.setFactor (factor, type);
+        ReferenceDecimatorChain refLeft (factor, type == DECIMATOR_FIR_CHEAP);
+        ReferenceDecimatorChain refRight (factor, type == DECIMATOR_FIR_CHEAP);
+
+        Random random (factor * 3 + type);
+        std::vector<float> l (64 * factor), r (64 * factor);
+        float x[DecimatorChain::MAX_FACTOR];
+        int mismatches = 0;
+        for (int b = 0; b < 400; ++b)
+        {
+            const int n = blockSizes[b % numElementsInArray (blockSizes)];
+            for (int i = 0; i < n * factor; ++i)
+            {
+                l[i] = random.nextFloat() * 2 - 1;
+                r[i] = random.nextFloat() * 2 - 1;
+            }
+            std::vector<float> refOut (2 * n);
+            for (int i = 0; i < n; ++i)
+            {
+                std::copy (l.begin() + i * factor, l.begin() + (i + 1) * factor, x);
+                refOut[2 * i] = refLeft.calc (x);
+                std::copy (r.begin() + i * factor, r.begin() + (i + 1) * factor, x);
+                refOut[2 * i + 1] = refRight.calc (x);
+            }
+            chain.process (l.data(), r.data(), n);
+            for (int i = 0; i < n; ++i)
+                if (l[i] != refOut[2 * i] || r[i] != refOut[2 * i + 1])
+                    ++mismatches;
+        }
+        return mismatches;
+    }
+
+    // gain of a sine of bin cycles per window output samples, after the chain has settled
+    static double iirGainDb (int factor, int bin)
+    {
+        const int block = 64, settle = 16;
+        DecimatorChain chain;
+        chain.setFactor (factor, DECIMATOR_IIR);
+        std::vector<float> l (block * factor), r (block * factor);
+        const double increment = 2 * double_Pi * bin / ((double) window * factor);
+        int64 phase = 0;
+        double sum = 0;
+        for (int b = 0; b < settle + window / block; ++b)
+        {
+            for (int i = 0; i < block * factor; ++i)
+                l[i] = r[i] = (float) std::sin (increment * (double) phase++);
+            chain.process (l.data(), r.data(), block);
+            if (b >= settle)
+                for (int i = 0; i < block; ++i)
+                    sum += (double) l[i] * l[i];
+        }
+        return 10 * std::log10 (jmax (1e-30, 2 * sum / window));
+    }
+};
+
+static DecimatorTests decimatorTests;
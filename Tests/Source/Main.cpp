@@ -0,0 +1,40 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+
+//==============================================================================
+// Runs the engine checks, or the UnitTest category named on the command line
+// ("Benchmarks" for the timing and size reports), and fails when any expectation fails
+int main (int argc, char* argv[])
+{
+    UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTestsInCategory (argc > 1 ? String (argv[1]) : String ("Engine"));
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult (i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+#include "../../Source/Engine/SynthEngine.h"
+
+//==============================================================================
+// Time per sample of the oscillator kernel for the waveform and sync combinations
+class OscillatorBenchmark : public UnitTest
+{
+public:
+    OscillatorBenchmark() : UnitTest ("Oscillator kernels", "Benchmarks") {}
+
+    void runTest() override
+    {
+        struct Config { const char* name; bool saw1, pulse1, saw2, pulse2, sync, quantize; };
+        const Config configs[] =
+        {
+            { "saw/saw",                 true,  false, true,  false, false, false },
+            { "pulse/pulse",             false, true,  false, true,  false, false },
+            { "tri/tri",                 false, false, false, false, false, false },
+            { "saw/pulse + sync",        true,  false, false, true,  true,  false },
+            { "saw/saw + sync + quant",  true,  false, true,  false, true,  true  },
+        };
+        const int oscillators = 8, samples = 1000000;
+
+        beginTest ("ns per sample, 8 oscillators");
+        for (const Config& c : configs)
+        {
+            std::unique_ptr<ObxdOscillatorB[]> osc (new ObxdOscillatorB[oscillators]);
+            for (int i = 0; i < oscillators; ++i)
+            {
+                ObxdOscillatorB& o = osc[i];
+                o.setSampleRate (44100);
+                o.o1mx = o.o2mx = 1;
+                o.notePlaying = 20.0f + i * 3;
+                o.osc2Det = 0.1f;
+                o.osc2p = 7;
+                o.setOsc1Saw (c.saw1);
+                o.setOsc1Pulse (c.pulse1);
+                o.setOsc2Saw (c.saw2);
+                o.setOsc2Pulse (c.pulse2);
+                o.setHardSync (c.sync);
+                o.setQuantize (c.quantize);
+            }
+
+            float sum = 0;
+            const int64 start = Time::getHighResolutionTicks();
+            for (int n = 0; n < samples; ++n)
+                for (int i = 0; i < oscillators; ++i)
+                    sum += osc[i].ProcessSample();
+            const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+
+            expect (std::isfinite (sum));
+            logMessage (String (c.name) + " " + String (seconds * 1e9 / ((double) samples * oscillators), 2) + " ns");
+        }
+    }
+};
+
+static OscillatorBenchmark oscillatorBenchmark;
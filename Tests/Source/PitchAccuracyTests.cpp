@@ -0,0 +1,130 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+#include "../../Source/Engine/SynthEngine.h"
+
+//==============================================================================
+// Checks the pitch exponential tiers of AudioUtils.h against a double reference,
+// the scalar getPitch(index,precision) and the lane version in FilterBank
+class PitchAccuracyTests : public UnitTest
+{
+public:
+    PitchAccuracyTests() : UnitTest ("Pitch accuracy", "Engine") {}
+
+    void runTest() override
+    {
+        for (int precision = PITCH_EXACT; precision <= PITCH_FAST; ++precision)
+        {
+            beginTest ("Documented error, precision " + String (precision));
+            checkRange (precision, -200.0f, 200.0f, 0.0013f, true);
+
+            beginTest ("Octave clamp, precision " + String (precision));
+            checkRange (precision, -1600.0f, 1600.0f, 0.37f, false);
+        }
+
+        beginTest ("Octave joins");
+        for (int precision = PITCH_HIGH; precision <= PITCH_FAST; ++precision)
+        {
+            expectEquals (exp2Fraction (0.0f, precision), 1.0f);
+            expectLessOrEqual (exp2Fraction (1.0f - std::numeric_limits<float>::epsilon() * 0.5f, precision), 2.0f);
+        }
+    }
+
+private:
+    // max error in cents over +-200 semitones, as documented in AudioUtils.h
+    static double maxCents (int precision)
+    {
+        switch (precision)
+        {
+            case PITCH_EXACT: return 0.002;
+            case PITCH_HIGH:  return 0.002;
+            default:          return 0.15;
+        }
+    }
+
+    static double centError (float index, float pitch)
+    {
+        return std::abs (1200.0 * std::log2 (pitch / (440.0 * std::pow (2.0, index / 12.0))));
+    }
+
+    // sweeps [lo,hi] a lane group at a time
+    // within the documented range both paths have to stay inside the error bound,
+    // everywhere the lanes have to match the scalar result bit for bit, pitch has to rise
+    // with the index and the polynomial tiers have to hold their value beyond +-126 octaves
+    void checkRange (int precision, float lo, float hi, float step, bool checkError)
+    {
+        const int L = SimdFloat::Lanes;
+        const float clamp = 126.0f * 12;
+        const float atLowClamp = getPitch (-clamp, precision);
+        const float atHighClamp = getPitch (clamp, precision);
+        double scalarMax = 0, laneMax = 0;
+        int mismatches = 0, notRising = 0, notHeld = 0, invalid = 0;
+        float last = 0;
+        float index[SimdFloat::Lanes], lanes[SimdFloat::Lanes];
+
+        for (int n = 0; lo + (n + L - 1) * step <= hi; n += L)
+        {
+            for (int l = 0; l < L; ++l)
+                index[l] = lo + (n + l) * step;
+
+            FilterBank::getPitch (SimdFloat::load (index), precision).store (lanes);
+
+            for (int l = 0; l < L; ++l)
+            {
+                const float pitch = getPitch (index[l], precision);
+
+                if (lanes[l] != pitch)
+                    ++mismatches;
+                if (std::isnan (pitch) || pitch < 0)
+                    ++invalid;
+                if (pitch < last)
+                    ++notRising;
+                if (precision != PITCH_EXACT
+                    && ((index[l] <= -clamp && pitch != atLowClamp) || (index[l] >= clamp && pitch != atHighClamp)))
+                    ++notHeld;
+                last = pitch;
+
+                if (checkError)
+                {
+                    scalarMax = jmax (scalarMax, centError (index[l], pitch));
+                    laneMax = jmax (laneMax, centError (index[l], lanes[l]));
+                }
+            }
+        }
+
+        expectEquals (mismatches, 0, "lanes differ from the scalar path");
+        expectEquals (invalid, 0, "negative or NaN pitch");
+        expectEquals (notRising, 0, "pitch falls as the index rises");
+        expectEquals (notHeld, 0, "pitch changes beyond the octave clamp");
+
+        if (checkError)
+        {
+            logMessage ("max error " + String (scalarMax, 6) + " cent scalar, " + String (laneMax, 6) + " cent lanes");
+            expectLessOrEqual (scalarMax, maxCents (precision), "scalar path above the documented error");
+            expectLessOrEqual (laneMax, maxCents (precision), "lane path above the documented error");
+        }
+    }
+};
+
+static PitchAccuracyTests pitchAccuracyTests;
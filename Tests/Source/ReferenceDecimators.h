@@ -0,0 +1,132 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#pragma once
+
+//==============================================================================
+// The per sample transposed half band decimators the engine used before
+// HalfBandFir, kept as the reference the block decimators have to match
+class ReferenceDecimator17
+{
+public:
+    float calc (const float x0, const float x1)
+    {
+        const float h17x0 = h17 * x0;
+        const float h15x0 = h15 * x0;
+        const float h13x0 = h13 * x0;
+        const float h11x0 = h11 * x0;
+        const float h9x0 = h9 * x0;
+        const float h7x0 = h7 * x0;
+        const float h5x0 = h5 * x0;
+        const float h3x0 = h3 * x0;
+        const float h1x0 = h1 * x0;
+        const float r18 = r[17] + h17x0;
+        r[17] = r[16] + h15x0;
+        r[16] = r[15] + h13x0;
+        r[15] = r[14] + h11x0;
+        r[14] = r[13] + h9x0;
+        r[13] = r[12] + h7x0;
+        r[12] = r[11] + h5x0;
+        r[11] = r[10] + h3x0;
+        r[10] = r[9] + h1x0;
+        r[9] = r[8] + h1x0 + h0 * x1;
+        r[8] = r[7] + h3x0;
+        r[7] = r[6] + h5x0;
+        r[6] = r[5] + h7x0;
+        r[5] = r[4] + h9x0;
+        r[4] = r[3] + h11x0;
+        r[3] = r[2] + h13x0;
+        r[2] = r[1] + h15x0;
+        r[1] = h17x0;
+        return r18;
+    }
+
+private:
+    const float h0 = 0.5f, h1 = 0.314356238f, h3 = -0.0947515890f, h5 = 0.0463142134f, h7 = -0.0240881704f,
+                h9 = 0.0120250406f, h11 = -0.00543170841f, h13 = 0.00207426259f, h15 = -0.000572688237f,
+                h17 = 5.18944944e-005f;
+    float r[18] = {};
+};
+
+class ReferenceDecimator9
+{
+public:
+    float calc (const float x0, const float x1)
+    {
+        const float h9x0 = h9 * x0;
+        const float h7x0 = h7 * x0;
+        const float h5x0 = h5 * x0;
+        const float h3x0 = h3 * x0;
+        const float h1x0 = h1 * x0;
+        const float r10 = r[9] + h9x0;
+        r[9] = r[8] + h7x0;
+        r[8] = r[7] + h5x0;
+        r[7] = r[6] + h3x0;
+        r[6] = r[5] + h1x0;
+        r[5] = r[4] + h1x0 + h0 * x1;
+        r[4] = r[3] + h3x0;
+        r[3] = r[2] + h5x0;
+        r[2] = r[1] + h7x0;
+        r[1] = h9x0;
+        return r10;
+    }
+
+private:
+    const float h0 = 8192 / 16384.0f, h1 = 5042 / 16384.0f, h3 = -1277 / 16384.0f, h5 = 429 / 16384.0f,
+                h7 = -116 / 16384.0f, h9 = 18 / 16384.0f;
+    float r[10] = {};
+};
+
+// one channel, the 9 tap stages first and the 17 tap one last unless cheap
+class ReferenceDecimatorChain
+{
+public:
+    ReferenceDecimatorChain (int factor, bool cheapLast) : cheap (cheapLast)
+    {
+        while ((2 << stages) <= factor)
+            ++stages;
+    }
+
+    // x holds factor samples in time order and is used as scratch
+    float calc (float* x)
+    {
+        if (stages == 0)
+            return x[0];
+
+        int n = 1 << stages;
+        for (int s = 0; s < stages - 1; ++s)
+        {
+            n >>= 1;
+            for (int i = 0; i < n; ++i)
+                x[i] = early[s].calc (x[2 * i], x[2 * i + 1]);
+        }
+        return cheap ? lastCheap.calc (x[0], x[1]) : last.calc (x[0], x[1]);
+    }
+
+private:
+    ReferenceDecimator9 early[2];
+    ReferenceDecimator17 last;
+    ReferenceDecimator9 lastCheap;
+    int stages = 0;
+    bool cheap;
+};
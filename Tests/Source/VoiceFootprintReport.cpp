@@ -0,0 +1,90 @@
+/*
+	==============================================================================
+	This file is part of Obxd synthesizer.
+
+	Copyright ) 2013-2014 Filatov Vadim
+	
+	Contact author via email :
+	justdat_@_e1.ru
+
+	This file may be licensed under the terms of of the
+	GNU General Public License Version 2 (the ``GPL'').
+
+	Software distributed under the License is distributed
+	on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+	express or implied. See the GPL for the specific language
+	governing rights and limitations.
+
+	You should have received a copy of the GPL along with this
+	program. If not, go to http://www.gnu.org/licenses/gpl.html
+	or write to the Free Software Foundation, Inc.,  
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+	==============================================================================
+ */
+#include <JuceHeader.h>
+#include "../../Source/Engine/SynthEngine.h"
+
+//==============================================================================
+// Size of the voice and its parts, the placement of the pool, and the render
+// time of a full pool with every voice playing
+class VoiceFootprintReport : public UnitTest
+{
+public:
+    VoiceFootprintReport() : UnitTest ("Voice footprint", "Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest ("sizeof");
+        logMessage ("ObxdVoice " + String ((int) sizeof (ObxdVoice)) + " bytes");
+        logMessage ("ObxdOscillatorB " + String ((int) sizeof (ObxdOscillatorB)) + " bytes");
+        logMessage ("SawOsc " + String ((int) sizeof (SawOsc)) + ", PulseOsc " + String ((int) sizeof (PulseOsc))
+                    + ", TriangleOsc " + String ((int) sizeof (TriangleOsc)) + " bytes");
+        logMessage ("32 voice pool " + String (32 * sizeof (ObxdVoice) / 1024.0, 1) + " KB");
+        logMessage ("128 voice pool " + String (128 * sizeof (ObxdVoice) / 1024.0, 1) + " KB");
+
+        beginTest ("Every voice starts on its own cache line");
+        expectEquals ((int) alignof (ObxdVoice), 64);
+        std::unique_ptr<Motherboard> board (new Motherboard());
+        for (int count : { 1, 32, Motherboard::MAX_VOICES })
+        {
+            board->setVoicePoolSize (count);
+            for (int i = 0; i < count; ++i)
+                expectEquals ((int) ((uintptr_t) (board->voices + i) & 63), 0);
+        }
+
+        beginTest ("Render time, 1 s of 128 voices at 2x oversampling");
+        logMessage (String (renderMs(), 1) + " ms");
+    }
+
+private:
+    double renderMs()
+    {
+        const int sampleRate = 44100, block = 256;
+        std::unique_ptr<SynthEngine> synth (new SynthEngine());
+        synth->setVoicePoolSize (Motherboard::MAX_VOICES);
+        synth->setSampleRate (sampleRate);
+        synth->setVoiceCount (1.0f);
+        synth->procEconomyMode (0.0f);
+        synth->processOversampling (1.0f);
+        synth->processOsc1Saw (1);
+        synth->processOsc2Pulse (1);
+        synth->processOsc1Mix (1);
+        synth->processOsc2Mix (1);
+        synth->processFilterEnvelopeAmt (0.4f);
+        for (int k = 0; k < Motherboard::MAX_VOICES; ++k)
+            synth->procNoteOn (k, 0.8f);
+
+        float left[block], right[block];
+        float sum = 0;
+        const int64 start = Time::getHighResolutionTicks();
+        for (int pos = 0; pos < sampleRate; pos += block)
+        {
+            synth->processBlock (left, right, block);
+            sum += left[0] + right[0];
+        }
+        expect (std::isfinite (sum));
+        return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1000;
+    }
+};
+
+static VoiceFootprintReport voiceFootprintReport;